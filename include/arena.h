@@ -0,0 +1,34 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+/*
+Chunked bump allocator.
+Memory is handed out from large chunks and only released with the arena,
+so pointers stay valid and allocations cost no malloc call as long as the
+current chunk has room.
+*/
+class Arena {
+ public:
+  explicit Arena(std::size_t chunkSize = 64 * 1024);
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+  Arena(Arena&&) = default;
+  Arena& operator=(Arena&&) = default;
+
+  void* Allocate(std::size_t size,
+                 std::size_t alignment = alignof(std::max_align_t));
+  std::size_t Capacity() const;
+
+ private:
+  std::vector<std::unique_ptr<char[]>> _chunks;
+  std::size_t _chunkSize;
+  char* _current{nullptr};
+  std::size_t _left{0};
+  std::size_t _capacity{0};
+};
+
+#endif
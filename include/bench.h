@@ -0,0 +1,12 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+/*
+Headless benchmarks of the collection path, run with --bench [ticks].
+The process exit code is non zero if an assertion fails.
+*/
+namespace Bench {
+int Run(int ticks);
+};  // namespace Bench
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef EXPORTER_H
+#define EXPORTER_H
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class System;
+
+/*
+Serves the latest tick of a System in the OpenMetrics text format over
+HTTP, on a local TCP address ("127.0.0.1:9273") or a Unix socket (an
+address starting with '/').
+The body is rendered once per tick by the collecting thread into a pooled
+buffer, which is reused as soon as no scraper holds it any more. One
+server thread serves any number of concurrent scrapers with non-blocking
+sockets; a scraper takes a reference to the current body and never causes
+collecting or rendering. Per process series are limited to the top
+processes by cpu, so the cardinality does not grow with the host.
+*/
+class Exporter {
+ public:
+  static constexpr const char* kDefaultAddress = "127.0.0.1:9273";
+  static constexpr std::size_t kDefaultTop = 20;
+
+  Exporter() = default;
+  Exporter(const Exporter&) = delete;
+  Exporter& operator=(const Exporter&) = delete;
+  ~Exporter();
+
+  bool Open(const std::string& address);
+  void Render(System& system, std::size_t top);
+  std::shared_ptr<const std::string> Body() const;
+  void Run();
+
+  static int Serve(System& system, const std::string& address, std::size_t top);
+
+ private:
+  struct Connection;
+
+  bool respond(Connection& connection);
+
+  int _listen{-1};
+  std::string _path;  // of a Unix socket, removed on destruction
+  // rendered bodies, a buffer is free while only the pool holds it
+  std::vector<std::shared_ptr<std::string>> _buffers;
+  std::vector<int> _rows;
+  mutable std::mutex _mutex;
+  std::shared_ptr<const std::string> _current;
+};
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef FIELD_TABLE_H
+#define FIELD_TABLE_H
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/*
+Extraction of "Key: value" or "key value" files like /proc/<pid>/status,
+/proc/meminfo or /proc/vmstat.
+The wanted keys and the members they fill are listed at compile time, a
+hash of length, first and last character of a key is checked to be free of
+collisions at compile time as well. One scan over the file looks up every
+line key with a single table access and stops as soon as all keys are
+found.
+*/
+template <typename Struct>
+struct Field {
+  std::string_view key;
+  long Struct::*member;
+};
+
+template <typename Struct, std::size_t N>
+class FieldTable {
+  static_assert(N > 0 && N <= 64, "found keys are tracked in a 64 bit mask");
+
+ public:
+  constexpr explicit FieldTable(const Field<Struct> (&fields)[N]) {
+    for (std::size_t i = 0; i < N; ++i) {
+      _fields[i] = fields[i];
+      const std::size_t slot = hash(fields[i].key);
+      _collisions += (_slots[slot] != 0);
+      _slots[slot] = static_cast<std::uint8_t>(i + 1);
+    }
+  }
+
+  // false if two keys share a slot, check with static_assert
+  constexpr bool Perfect() const { return _collisions == 0; }
+
+  // Fill the members of all keys found in content, members of missing
+  // keys are left unchanged. Returns the number of keys found.
+  // skip drops a prefix of every line, like "Node 0 " in node meminfo.
+  std::size_t Extract(std::string_view content, Struct& target,
+                      std::size_t skip = 0) const {
+    constexpr std::uint64_t all = (N == 64) ? ~std::uint64_t{0} : (std::uint64_t{1} << N) - 1;
+    std::uint64_t found = 0;
+    std::size_t count = 0;
+    while (!content.empty() && found != all) {
+      const std::size_t end = std::min(content.find('\n'), content.size());
+      std::string_view line = content.substr(0, end);
+      content.remove_prefix(std::min(end + 1, content.size()));
+      line.remove_prefix(std::min(skip, line.size()));
+
+      const std::size_t colon = line.find_first_of(": ");
+      if (colon == 0 || colon == std::string_view::npos) continue;
+      const std::string_view key = line.substr(0, colon);
+      const std::uint8_t index = _slots[hash(key)];
+      if (index == 0 || _fields[index - 1].key != key) continue;
+
+      line.remove_prefix(colon + 1);
+      while (!line.empty() && (line.front() == ' ' || line.front() == '\t'))
+        line.remove_prefix(1);
+      std::from_chars(line.data(), line.data() + line.size(),
+                      target.*(_fields[index - 1].member));
+      const std::uint64_t bit = std::uint64_t{1} << (index - 1);
+      count += (found & bit) == 0;
+      found |= bit;
+    }
+    return count;
+  }
+
+ private:
+  static constexpr std::size_t kSlots = 256;
+
+  static constexpr std::size_t hash(std::string_view key) {
+    return (key.size() * 31 + static_cast<unsigned char>(key.front()) * 7 +
+            static_cast<unsigned char>(key.back())) % kSlots;
+  }
+
+  Field<Struct> _fields[N] = {};
+  std::uint8_t _slots[kSlots] = {};
+  std::size_t _collisions{0};
+};
+
+#endif
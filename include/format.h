@@ -1,6 +1,7 @@
 #ifndef FORMAT_H
 #define FORMAT_H
 
+#include <cstdint>
 #include <string>
 
 namespace Format {
@@ -8,6 +9,8 @@ std::string ElapsedTime(long times);
 std::string Ram(int ram);
 std::string Pid(int pid);  
 std::string Command(std::string command, int maxSize = 100);  
+std::string Duration(std::uint64_t nanoseconds);
+std::string Rate(float perSecond);
 };                                    // namespace Format
 
 #endif
\ No newline at end of file
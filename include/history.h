@@ -0,0 +1,92 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <cstddef>
+#include <initializer_list>
+#include <vector>
+
+#include "process.h"
+
+/*
+Fixed capacity time series with multiple resolutions.
+Every resolution is a columnar ring buffer (avg, min, max) which is
+allocated once at construction, so appending is O(1) and memory is constant.
+*/
+class TimeSeries {
+ public:
+  struct Resolution {
+    std::size_t step;      // raw samples folded into one point
+    std::size_t capacity;  // number of points kept
+  };
+
+  struct Summary {
+    float min{0};
+    float avg{0};
+    float max{0};
+  };
+
+  // 1s for 10 min, 10s for 2h, 1min for a day (one raw sample per tick)
+  TimeSeries(std::initializer_list<Resolution> resolutions = {
+                 {1, 600}, {10, 720}, {60, 1440}});
+  void Append(float value);
+  void Clear();
+  std::size_t Size(std::size_t tier = 0) const;
+  void Recent(std::size_t n, std::vector<float>& values,
+              std::size_t tier = 0) const;
+  Summary Summarize(std::size_t n, std::size_t tier = 0) const;
+
+ private:
+  struct Tier {
+    std::size_t step;
+    std::size_t capacity;
+    std::size_t head{0};
+    std::size_t size{0};
+    std::vector<float> avg;
+    std::vector<float> min;
+    std::vector<float> max;
+
+    // pending point, folded from raw samples until step is reached
+    std::size_t pendingCount{0};
+    float pendingSum{0};
+    float pendingMin{0};
+    float pendingMax{0};
+  };
+
+  std::vector<Tier> _tiers;
+};
+
+/*
+History of the system metrics and of the top processes
+*/
+class MetricHistory {
+ public:
+  // number of process slots kept for the top processes
+  static constexpr std::size_t kTopProcesses = 10;
+
+  MetricHistory();
+  void RecordSystem(float cpu, const std::vector<float>& cores, float memory,
+                    float load);
+  void RecordProcesses(const std::vector<Process>& processes,
+                       const std::vector<int>& top);
+
+  const TimeSeries& Cpu() const;
+  const std::vector<TimeSeries>& Cores() const;
+  const TimeSeries& Memory() const;
+  const TimeSeries& Load() const;
+  const TimeSeries* ProcessCpu(int pid) const;
+
+ private:
+  struct ProcessSlot {
+    int pid{-1};
+    TimeSeries cpu{{1, 600}};
+    TimeSeries ram{{1, 600}};
+  };
+
+  TimeSeries _cpu;
+  std::vector<TimeSeries> _cores;
+  TimeSeries _memory;
+  TimeSeries _load;
+  std::vector<ProcessSlot> _processes;
+};
+
+#endif
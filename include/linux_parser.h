@@ -1,40 +1,68 @@
 #ifndef SYSTEM_PARSER_H
 #define SYSTEM_PARSER_H
 
+#include <cstdint>
 #include <fstream>
 #include <regex>
 #include <string>
+#include <string_view>
+#include <vector>
 
 namespace LinuxParser {
 // Paths
 const std::string kProcDirectory{"/proc/"};
 const std::string kCmdlineFilename{"/cmdline"};
+const std::string kCommFilename{"/comm"};
 const std::string kCpuinfoFilename{"/cpuinfo"};
 const std::string kStatusFilename{"/status"};
 const std::string kStatFilename{"/stat"};
+const std::string kStatmFilename{"/statm"};
+const std::string kSchedstatFilename{"/schedstat"};
+const std::string kVmstatFilename{"/vmstat"};
 const std::string kUptimeFilename{"/uptime"};
 const std::string kMeminfoFilename{"/meminfo"};
+const std::string kLoadavgFilename{"/loadavg"};
 const std::string kVersionFilename{"/version"};
 const std::string kOSPath{"/etc/os-release"};
 const std::string kPasswordPath{"/etc/passwd"};
+const std::string kNodeDirectory{"/sys/devices/system/node/"};
+const std::string kCpulistFilename{"/cpulist"};
+const std::string kNumaMapsFilename{"/numa_maps"};
 
 // Filter Keys
 const std::string kFilterProcesses("processes");
 const std::string kFilterRunningProcesses("procs_running");
-const std::string kFilterMemTotal("MemTotal");
-const std::string kFilterMemFree("MemFree");
 const std::string kFilterCpu("cpu");
-const std::string kFilterUID("Uid");
-const std::string kFilterProcMem("VmSize");
+const std::string kFilterContextSwitches("ctxt");
 
 // System
+struct MemInfo {  // kB
+  long total{0};
+  long free{0};
+  long available{0};
+  long buffers{0};
+  long cached{0};
+  long swapTotal{0};
+  long swapFree{0};
+};
+bool Meminfo(MemInfo& memory);
+struct SchedCounters {  // cumulative since boot
+  long waitNs{-1};  // run queue wait of all cpus, -1 without /proc/schedstat
+  long contextSwitches{0};
+  long faults{0};   // minor and major
+  long majorFaults{0};
+};
+void Scheduling(SchedCounters& counters);
 float MemoryUtilization();
 long UpTime();
 std::vector<int> Pids();
+void Pids(std::vector<int>& pids);
 int TotalProcesses();
 int RunningProcesses();
 std::string OperatingSystem();
 std::string Kernel();
+float LoadAverage();
+std::uint64_t Syscalls();
 
 // CPU
 enum CPUStates {
@@ -50,16 +78,58 @@ enum CPUStates {
   kGuestNice_
 };
 std::vector<long> CpuUtilization();
+void CpuUtilizations(std::vector<std::vector<long>>& cpus,
+                     std::vector<int>& ids);
 long Jiffies(const std::vector<long>& jiffies);
 long ActiveJiffies(const std::vector<long>& jiffies);
 long ActiveJiffies(int pid);
 long IdleJiffies(const std::vector<long>& jiffies);
 
+// NUMA
+std::vector<int> NumaNodes();
+std::vector<int> NodeCpus(int node);
+bool NodeMeminfo(int node, MemInfo& memory);
+bool NumaMaps(int pid, std::vector<long>& nodeKb);
+
 // Processes
+struct ProcStat {
+  long activeJiffies{0};  // utime + stime + cutime + cstime
+  long startTime{0};      // jiffies after boot
+  long minorFaults{0};
+  long majorFaults{0};
+  long vsize{0};  // bytes
+  long rss{0};    // pages
+  std::uint32_t comm{0};  // hash of the command name (#2), changes on exec,
+                          // 0 for kernel threads
+};
+bool Stat(int pid, ProcStat& stat);
+bool ParseStat(std::string_view content, ProcStat& stat);
+struct ProcStatus {
+  long uid{0};
+  long vmRss{0};   // kB
+  long vmSwap{0};  // kB
+  long threads{0};
+  long voluntarySwitches{0};
+  long involuntarySwitches{0};
+};
+bool Status(int pid, ProcStatus& status);
+struct ProcSchedstat {
+  long runNs{0};
+  long waitNs{0};  // waiting on a run queue
+};
+bool Schedstat(int pid, ProcSchedstat& schedstat);
+struct ProcStatm {
+  int size{0};      // mb, same as VmSize
+  int resident{0};  // mb, same as VmRSS
+};
+bool Statm(int pid, ProcStatm& statm);
+bool ParseStatm(std::string_view content, ProcStatm& statm);
+void StatmOf(const ProcStat& stat, ProcStatm& statm);
 std::string Command(int pid);
 int Ram(int pid);
 int Uid(int pid);
 std::string User(int pid);
+std::string UserName(int uid);
 long int UpTime(int pid);
 };  // namespace LinuxParser
 
@@ -3,14 +3,29 @@
 
 #include <curses.h>
 
+#include "history.h"
 #include "process.h"
+#include "process_table.h"
 #include "system.h"
 
 namespace NCursesDisplay {
-void Display(System& system, int n = 10);
+void Display(System& system, bool selfStats = false, bool numa = false);
 void DisplaySystem(System& system, WINDOW* window);
-void DisplayProcesses(std::vector<Process>& processes, WINDOW* window, int n);
+void DisplayProcesses(std::vector<Process>& processes,
+                      const std::vector<int>& rows, int first, int cursor,
+                      ProcessTable::SortKey sort, const MetricHistory& history,
+                      WINDOW* window, int n);
+void DisplayStatus(const ProcessTable::View& view, std::size_t shown,
+                   std::size_t total, const std::string& message,
+                   WINDOW* window);
+void DisplaySelfStats(WINDOW* window);
+void DisplayNuma(const Numa& numa, const std::vector<Process>& processes,
+                 WINDOW* window);
 std::string ProgressBar(float percent);
+std::string Sparkline(const std::vector<float>& values, int width,
+                      float scale = 0);
+std::string Summary(const TimeSeries& series, float scale,
+                    const std::string& unit);
 };  // namespace NCursesDisplay
 
 #endif
\ No newline at end of file
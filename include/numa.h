@@ -0,0 +1,46 @@
+#ifndef NUMA_H
+#define NUMA_H
+
+#include <cstddef>
+#include <vector>
+
+#include "process.h"
+
+/*
+NUMA nodes of the machine with their cpu and memory utilization.
+The topology (nodes and their cpus) is discovered once by Discover, a
+default constructed Numa reads nothing and reports no nodes.
+Page placement of processes comes from /proc/<pid>/numa_maps, which is
+expensive for the kernel, so it is only sampled on request and for a few
+processes.
+*/
+class Numa {
+ public:
+  struct Node {
+    int id{0};
+    std::vector<int> cpus;
+    float cpuUtilization{0};
+    long memTotal{0};  // kB
+    long memFree{0};   // kB
+  };
+
+  struct ProcessPages {
+    int pid{-1};
+    std::vector<long> kb;  // resident kB per index into Nodes()
+  };
+
+  void Discover();
+  bool Available() const;
+  const std::vector<Node>& Nodes() const;
+  void Update(const std::vector<float>& coreUtilizations);
+  void UpdateProcesses(const std::vector<Process>& processes,
+                       const std::vector<int>& rows, std::size_t count);
+  const std::vector<ProcessPages>& Processes() const;
+
+ private:
+  std::vector<Node> _nodes;
+  std::vector<ProcessPages> _processes;
+  std::vector<long> _nodeKb;  // by node id, reused per process
+};
+
+#endif
@@ -0,0 +1,54 @@
+#ifndef PROC_READER_H
+#define PROC_READER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "linux_parser.h"
+
+/*
+Reads /proc/<pid>/stat and /proc/<pid>/statm of all processes once per tick
+and parses them with the LinuxParser parsers.
+The synchronous backend issues open/read/close per file. The io_uring
+backend submits the opens of a whole batch of pids at once, then their
+reads each hard linked to a close, and harvests the completions into
+preallocated buffers: two io_uring_enter calls per batch. If io_uring is
+not available, or fails later on, the synchronous backend is used.
+A read of stat only takes the memory values from stat instead of statm,
+for a cheap first pass over all processes.
+*/
+class ProcReader {
+ public:
+  enum Backend { kSync_ = 0, kUring_ };
+
+  struct Sample {
+    LinuxParser::ProcStat stat;
+    LinuxParser::ProcStatm statm;
+    bool valid{false};  // false if the process is gone
+  };
+
+  ProcReader();
+  ProcReader(const ProcReader&) = delete;
+  ProcReader& operator=(const ProcReader&) = delete;
+  ~ProcReader();
+
+  bool UseUring();
+  Backend Active() const;
+  static const char* Name(Backend backend);
+  void Read(const std::vector<int>& pids, std::vector<Sample>& samples,
+            bool statOnly = false);
+  std::uint64_t Syscalls() const;
+
+ private:
+  struct Ring;
+
+  void readSync(int pid, Sample& sample, bool statOnly);
+  bool readUring(const int* pids, std::size_t count, Sample* samples);
+
+  std::unique_ptr<Ring> _ring;
+  std::uint64_t _syscalls{0};
+};
+
+#endif
@@ -1,27 +1,101 @@
 #ifndef PROCESS_H
 #define PROCESS_H
 
+#include <cstdint>
 #include <string>
+
+#include "linux_parser.h"
+#include "string_pool.h"
 /*
 Basic class for Process representation
 It contains relevant attributes as shown below
+Strings are interned, so a Process owns no heap memory and is cheap to move
+A provisional Process is built from its stat alone, user and command are
+empty until Resolve
 */
 class Process {
  public:
-    Process(const int id);
-    int Pid() const;                              
-    std::string User() const;                      
-    std::string Command() const;                   
-    float CpuUtilization();                  
-    int Ram();                       
-    long int UpTime();                       
-    bool operator<(Process const& other) const;  
- 
+    // values of a process collected elsewhere, e.g. by a snapshot publisher
+    struct Record {
+        int pid;
+        int uid;
+        long startTime;
+        StringPool::Handle user;
+        StringPool::Handle command;
+        float cpu;
+        float recentCpu;
+        int ram;
+        int rss;
+        long upTime;
+        float waitRate;
+        float voluntaryRate;
+        float involuntaryRate;
+        float minorFaultRate;
+        float majorFaultRate;
+        bool rated;
+    };
+
+    explicit Process(const Record& record);
+    Process(const int id, long systemUpTime, const LinuxParser::ProcStat& stat,
+            const LinuxParser::ProcStatm& statm);
+    bool Resolved() const;
+    void Resolve(int uid, StringPool::Handle user, StringPool::Handle command);
+    bool Update(long systemUpTime, const LinuxParser::ProcStat& stat,
+                const LinuxParser::ProcStatm& statm);
+    void Sample(std::uint64_t now);
+    int Pid() const;
+    int Uid() const;
+    long StartTime() const;
+    std::string User() const;
+    StringPool::Handle UserHandle() const;
+    std::string Command() const;
+    StringPool::Handle CommandHandle() const;
+    float CpuUtilization() const;
+    float RecentCpuUtilization() const;
+    int Ram() const;
+    int Rss() const;
+    long int UpTime() const;
+    float WaitRate() const;
+    float VoluntarySwitchRate() const;
+    float InvoluntarySwitchRate() const;
+    float MinorFaultRate() const;
+    float MajorFaultRate() const;
+    bool Rated() const;
+    bool operator<(Process const& other) const;
+
  private:
     int _id;
-    std::string _user;
-    std::string _command;
-    float _cpuUsage{0};
+    int _uid;
+    long _startTime;
+    StringPool::Handle _user;
+    StringPool::Handle _command;
+    bool _resolved{true};  // false until user and command are known
+    std::uint32_t _comm{0};  // hash of the command name, see ProcStat
+    float _cpuUsage{0};  // over the lifetime
+    float _recentCpuUsage{0};  // since the previous Update
+    long _activeJiffies{0};
+    std::uint64_t _updatedAt{0};  // of the latest Update, monotonic ns
+    int _ram{0};
+    int _rss{0};
+    long _upTime{0};
+
+    // fault counters of the latest Update
+    long _minorFaults{0};
+    long _majorFaults{0};
+    // counters of the latest Sample, 0 = never sampled
+    std::uint64_t _sampledAt{0};
+    long _sampledWaitNs{0};
+    long _sampledVoluntary{0};
+    long _sampledInvoluntary{0};
+    long _sampledMinorFaults{0};
+    long _sampledMajorFaults{0};
+    // per second since the previous Sample, 0 unless sampled this tick
+    float _waitRate{0};  // ms
+    float _voluntaryRate{0};
+    float _involuntaryRate{0};
+    float _minorFaultRate{0};
+    float _majorFaultRate{0};
+    bool _rated{false};  // rates above were sampled this tick
 };
 
-#endif
\ No newline at end of file
+#endif
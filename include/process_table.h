@@ -0,0 +1,146 @@
+#ifndef PROCESS_TABLE_H
+#define PROCESS_TABLE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <regex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "proc_reader.h"
+#include "process.h"
+#include "string_pool.h"
+
+/*
+Table of all processes, kept across ticks and keyed by pid.
+Besides the rows it maintains secondary indices, so a filter does not have
+to look at every process string:
+ - per user buckets (uid -> rows)
+ - interned command handles (row -> handle into StringPool::Commands()),
+   filters are evaluated once per distinct command and cached until the
+   filter changes; each row retains its command, so commands of processes
+   gone since the previous Update are evicted from the pool
+The numeric values of every row are mirrored into columns as well, written
+while the row is updated, so scans like alert rules run over contiguous
+values. The state of alert rules is kept per row, one column per rule, so
+it follows the pid and is dropped together with the process.
+A provisional Update reads stat only and adds new processes without user
+and command; Resolve looks them up for some rows, e.g. the visible ones,
+the next full Update for all others. A process whose command name changed
+in stat called exec and is resolved again the same way.
+*/
+class ProcessTable {
+ public:
+  enum SortKey {
+    kSortCpu_ = 0,
+    kSortRam_,
+    kSortPid_,
+    kSortUser_,
+    kSortTime_,
+    kSortCommand_,
+    kSortWait_,
+    kSortSwitches_,
+    kSortFaults_
+  };
+
+  enum Column {
+    kColumnCpu_ = 0,  // since the previous Update
+    kColumnRam_,
+    kColumnRss_,
+    kColumnWait_,
+    kColumnSwitches_,  // voluntary + involuntary
+    kColumnFaults_,    // minor + major
+    kColumns_
+  };
+
+  // state of one alert rule for every row, see Rules
+  struct RuleState {
+    std::uint8_t* flags;
+    std::uint32_t* since;
+  };
+
+  // state of an alert rule for a row removed by the last Update
+  struct RemovedRule {
+    std::size_t rule;  // state column, see Rule
+    std::uint8_t flags;
+    int pid;
+    StringPool::Handle user;
+    StringPool::Handle command;
+  };
+
+  struct View {
+    SortKey sort{kSortCpu_};
+    bool reverse{false};
+    std::string user;     // substring of user name, empty = all
+    std::string command;  // substring or regex of command, empty = all
+    bool regex{false};
+  };
+
+  ProcessTable() = default;
+  ProcessTable(const ProcessTable&) = delete;
+  ProcessTable& operator=(const ProcessTable&) = delete;
+  ~ProcessTable();
+
+  void Update(const std::vector<int>& pids, bool provisional = false);
+  void Update(const std::vector<Process>& processes);
+  void Sample(const std::vector<int>& pids);
+  void Resolve(const std::vector<int>& pids);
+  std::size_t Added() const;
+  std::size_t Pending() const;
+  ProcReader& Reader();
+  std::vector<Process>& Processes();
+  std::size_t Size() const;
+  const Process* Find(int pid) const;
+  bool Select(const View& view, std::vector<int>& rows);
+  void Top(std::size_t n, std::vector<int>& rows) const;
+  const float* Values(Column column) const;
+  const StringPool::Handle* Users() const;
+  void ResizeRuleState(std::size_t rules);
+  RuleState Rule(std::size_t rule);
+  const std::vector<RemovedRule>& RemovedRules() const;
+
+ private:
+  void insert(Process&& process);
+  void resolve(std::size_t row);
+  void addToBucket(std::size_t row);
+  void removeFromBucket(std::size_t row);
+  void updateValues(std::size_t row);
+  void removeUnseen();
+  void remove(std::size_t row);
+  void setCommand(std::size_t row, StringPool::Handle command);
+  bool updateCommandFilter(const View& view);
+  bool commandMatches(StringPool::Handle command);
+  bool userMatches(int uid, const std::string& user);
+
+  std::vector<Process> _processes;
+  ProcReader _reader;
+  std::vector<ProcReader::Sample> _samples;
+  std::unordered_map<int, std::size_t> _rowOfPid;
+
+  // columns, one entry per row
+  std::vector<StringPool::Handle> _commands;
+  std::vector<StringPool::Handle> _users;
+  std::vector<float> _values[kColumns_];
+  std::vector<std::size_t> _bucketPositions;
+  std::vector<std::uint64_t> _seen;
+  std::vector<std::vector<std::uint8_t>> _ruleFlags;  // per rule
+  std::vector<std::vector<std::uint32_t>> _ruleSince;
+  std::vector<RemovedRule> _removedRules;  // non zero state of removed rows
+  std::uint64_t _generation{0};
+  std::size_t _added{0};
+  std::size_t _pending{0};  // provisional rows
+
+  // per user buckets
+  std::unordered_map<int, std::vector<std::size_t>> _userBuckets;
+  std::unordered_map<int, StringPool::Handle> _userNames;
+
+  // cached filter results per command handle (-1 unknown)
+  std::vector<std::int8_t> _commandMatches;
+  std::string _commandFilter;
+  bool _commandFilterRegex{false};
+  bool _commandFilterValid{true};
+  std::regex _commandRegex;
+};
+
+#endif
@@ -1,11 +1,14 @@
 #ifndef PROCESSOR_H
 #define PROCESSOR_H
 
+#include <vector>
 
 class Processor {
  public:
   Processor();
+  explicit Processor(const std::vector<long>& jiffies);
   float Utilization();
+  float Utilization(const std::vector<long>& jiffies);
 
  private:
  
@@ -0,0 +1,85 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*
+Self-profiling of the monitor.
+Scoped timers record into per-thread histograms, which are aggregated on
+demand without locking. Build with -DMONITOR_PROFILING=OFF to compile all
+PROFILE_* macros out.
+*/
+namespace Profiler {
+// Timed stages
+enum Stage {
+  kTick_ = 0,
+  kPids_,
+  kReadPids_,
+  kParsePid_,
+  kResolve_,
+  kUserLookup_,
+  kSample_,
+  kSort_,
+  kDisplaySystem_,
+  kDisplayProcesses_,
+  kDisplayStatus_,
+  kDisplayNuma_,
+  kDisplaySelfStats_,
+  kStageCount_
+};
+
+// Per tick counters, sampled from /proc/self/io
+enum Counter { kReadSyscalls_ = 0, kBytesRead_, kCounterCount_ };
+
+struct Percentiles {
+  std::uint64_t count{0};
+  std::uint64_t p50{0};
+  std::uint64_t p99{0};
+  std::uint64_t max{0};
+};
+
+std::uint64_t Now();
+void Record(Stage stage, std::uint64_t nanoseconds);
+void Record(Counter counter, std::uint64_t value);
+Percentiles Summarize(Stage stage);
+Percentiles Summarize(Counter counter);
+std::vector<std::string> Report();
+bool Enabled();
+
+class ScopedTimer {
+ public:
+  explicit ScopedTimer(Stage stage);
+  ~ScopedTimer();
+
+ private:
+  Stage _stage;
+  std::uint64_t _start;
+};
+
+// Times a whole tick and records its syscalls and bytes read
+class ScopedTick {
+ public:
+  ScopedTick();
+  ~ScopedTick();
+
+ private:
+  ScopedTimer _timer;
+  std::uint64_t _readSyscalls;
+  std::uint64_t _bytesRead;
+};
+};  // namespace Profiler
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_NAME_(line) PROFILE_CONCAT_(profileScope, line)
+
+#ifdef MONITOR_PROFILING
+#define PROFILE_SCOPE(stage) Profiler::ScopedTimer PROFILE_NAME_(__LINE__)(stage)
+#define PROFILE_TICK() Profiler::ScopedTick PROFILE_NAME_(__LINE__)
+#else
+#define PROFILE_SCOPE(stage)
+#define PROFILE_TICK()
+#endif
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef RULES_H
+#define RULES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <vector>
+
+#include "process.h"
+#include "process_table.h"
+#include "string_pool.h"
+
+class System;
+
+/*
+Alert rules read from a config file, one rule per line, '#' starts a
+comment:
+  process cpu > 90% for 30s
+  user alice rss > 8GB
+  memory available < 5%
+A rule applies to all processes, to the processes of one user or to the
+system. Every rule is compiled once into an instruction (metric, compare,
+threshold in the unit of the metric, user, duration), a tick then runs
+each instruction as one flat loop over a value column of the
+ProcessTable.
+Rate metrics are sampled for the top processes only, so the processes
+a rate rule applies to are watched, see Watch.
+How long a process rule holds is kept per row in the ProcessTable. An
+event is raised once a rule held for its duration and again once it
+stops holding or its process exits.
+*/
+class Rules {
+ public:
+  // process metrics are the columns of the ProcessTable
+  enum Metric {
+    kCpu_ = ProcessTable::kColumnCpu_,  // share of one core since the last tick
+    kRam_ = ProcessTable::kColumnRam_,  // mb
+    kRss_ = ProcessTable::kColumnRss_,  // mb
+    kWait_ = ProcessTable::kColumnWait_,          // ms per second
+    kSwitches_ = ProcessTable::kColumnSwitches_,  // per second
+    kFaults_ = ProcessTable::kColumnFaults_,      // per second
+    kSystemCpu_ = ProcessTable::kColumns_,
+    kMemoryUsed_,
+    kMemoryAvailable_,
+    kLoad_,
+    kMetrics_
+  };
+
+  enum Compare { kGreater_ = 0, kGreaterEqual_, kLess_, kLessEqual_ };
+
+  struct Rule {
+    std::string text;  // as written in the file
+    Metric metric{kCpu_};
+    Compare compare{kGreater_};
+    float threshold{0};  // in the unit of the metric
+    bool anyUser{true};
+    StringPool::Handle user{0};  // into StringPool::Users()
+    std::uint32_t duration{0};   // seconds
+    std::size_t state{0};  // column in the ProcessTable, or system state
+  };
+
+  struct Event {
+    bool firing;  // false once the rule stopped holding
+    std::size_t rule;
+    int pid;      // -1 for system rules
+    StringPool::Handle user;     // of the process
+    StringPool::Handle command;
+    float value;
+    bool exited;  // resolved since the process is gone, value unknown
+  };
+
+  bool Load(const std::string& path, std::string& error);
+  bool Add(const std::string& text, std::string& error);
+  const std::vector<Rule>& Program() const;
+  void Evaluate(System& system, std::uint32_t now);
+  void Evaluate(ProcessTable& table, std::uint32_t now);
+  const std::vector<Event>& Events() const;
+  bool Rates() const;
+  void Watch(ProcessTable& table, std::vector<int>& pids) const;
+  void Report(std::ostream& out) const;
+
+  static int Serve(System& system, Rules& rules, const std::string& alerts);
+
+ private:
+  std::vector<Rule> _program;
+  std::size_t _processRules{0};
+  std::vector<std::size_t> _order;  // process rules, sorted by metric
+  float _system[kMetrics_] = {};  // values of system metrics
+  std::vector<std::uint8_t> _systemFlags;  // state of system rules
+  std::vector<std::uint32_t> _systemSince;
+  std::vector<Event> _events;
+};
+
+#endif
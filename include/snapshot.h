@@ -0,0 +1,146 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <sys/types.h>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "process.h"
+#include "string_pool.h"
+
+class System;
+
+/*
+Snapshots of System and its processes in POSIX shared memory.
+One collector publishes (--publish), any number of displays and exporters
+attach read-only (--attach) and never touch /proc themselves.
+
+The segment holds two buffers, each guarded by a sequence number which is
+odd while the buffer is written (seqlock). The writer always fills the
+buffer which is not the latest one, so readers copy a complete tick
+without ever blocking the writer and retry only if they were overtaken
+twice. Strings are stored once per buffer in an append-only area and
+referenced by offset, offset 0 is the empty string. Once the area of a
+buffer is full it is rebuilt with the strings of the current processes
+and its generation changes, so readers drop the offsets they cached.
+A restarted publisher creates a new segment; readers notice when no tick
+arrives and the name refers to another segment, and switch over.
+*/
+namespace Snapshot {
+constexpr std::uint32_t kMagic = 0x4d4f4e35;  // "MON5"
+constexpr std::size_t kMaxCores = 256;
+constexpr std::size_t kMaxProcesses = 1 << 15;
+constexpr std::size_t kStringBytes = 8 << 20;  // per buffer
+constexpr std::size_t kNameLength = 64;
+const std::string kDefaultName{"/monitor"};
+
+struct SystemRecord {
+  float cpu;
+  float memory;
+  float memoryAvailable;
+  float load;
+  long upTime;
+  int totalProcesses;
+  int runningProcesses;
+  float waitRate;
+  float switchRate;
+  float minorFaultRate;
+  float majorFaultRate;
+  std::uint32_t cores;
+  float coreUtilizations[kMaxCores];
+};
+
+struct ProcessRecord {
+  int pid;
+  int uid;
+  long startTime;
+  std::uint32_t user;     // offset into the string area
+  std::uint32_t command;  // offset into the string area
+  float cpu;
+  float recentCpu;
+  int ram;
+  int rss;
+  long upTime;
+  float waitRate;
+  float voluntaryRate;
+  float involuntaryRate;
+  float minorFaultRate;
+  float majorFaultRate;
+  std::uint32_t rated;  // rates were sampled this tick
+};
+
+struct Buffer;
+struct Layout;
+
+int Serve(System& system, const std::string& name);
+};  // namespace Snapshot
+
+// Owns the segment, it is removed again when the publisher is destroyed.
+// Only one publisher per name runs at a time.
+class SnapshotPublisher {
+ public:
+  SnapshotPublisher() = default;
+  SnapshotPublisher(const SnapshotPublisher&) = delete;
+  SnapshotPublisher& operator=(const SnapshotPublisher&) = delete;
+  ~SnapshotPublisher();
+
+  bool Open(const std::string& name, System& system);
+  void Publish(System& system);
+
+ private:
+  std::uint32_t store(Snapshot::Buffer& buffer, StringPool::Handle handle,
+                      StringPool& pool, std::vector<std::uint32_t>& offsets,
+                      bool& full);
+  void forget(std::size_t index);
+
+  std::string _name;
+  int _fd{-1};  // of the segment, locked while publishing
+  Snapshot::Layout* _layout{nullptr};
+  // string offsets per buffer and handle of StringPool::Commands() and
+  // Users(), 0 = not stored yet; stored commands are retained
+  std::vector<std::uint32_t> _commandOffsets[2];
+  std::vector<std::uint32_t> _userOffsets[2];
+  std::vector<int> _rows;  // top processes, if there are too many
+};
+
+class SnapshotReader {
+ public:
+  SnapshotReader() = default;
+  SnapshotReader(const SnapshotReader&) = delete;
+  SnapshotReader& operator=(const SnapshotReader&) = delete;
+  ~SnapshotReader();
+
+  bool Open(const std::string& name);
+  std::string OperatingSystem() const;
+  std::string Kernel() const;
+  bool Read(Snapshot::SystemRecord& system, std::vector<Process>& processes);
+
+ private:
+  // local copy of the string area of one buffer
+  struct Mirror {
+    std::vector<char> text{'\0'};
+    std::uint32_t bytes{1};  // copied and validated
+    std::uint64_t generation{0};
+    // local pool handles per string offset, commands are retained
+    std::unordered_map<std::uint32_t, StringPool::Handle> commands;
+    std::unordered_map<std::uint32_t, StringPool::Handle> users;
+  };
+
+  bool map(int fd);
+  void reattach();
+  StringPool::Handle intern(std::uint32_t offset, const Mirror& mirror, StringPool& pool,
+                            std::unordered_map<std::uint32_t, StringPool::Handle>& handles);
+  static void forget(Mirror& mirror);
+
+  std::string _name;
+  const Snapshot::Layout* _layout{nullptr};
+  ino_t _inode{0};  // of the mapped segment
+  std::uint64_t _published{0};  // at the last Read
+  std::vector<Snapshot::ProcessRecord> _records;
+  Mirror _mirrors[2];
+};
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef STRING_POOL_H
+#define STRING_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "arena.h"
+
+/*
+Interned strings stored once in an arena.
+Equal strings get the same handle, so they can be compared by handle.
+Holders of a handle may count a reference with Retain; once the last one
+is released, Collect evicts the string and its handle is reused. Strings
+never retained stay for the lifetime of the pool. Collect also compacts
+the arena once most of it is held by evicted strings. Not thread safe.
+*/
+class StringPool {
+ public:
+  using Handle = std::uint32_t;
+
+  explicit StringPool(std::size_t chunkSize = 64 * 1024);
+  StringPool(const StringPool&) = delete;
+  StringPool& operator=(const StringPool&) = delete;
+
+  Handle Intern(std::string_view text);
+  std::string_view Get(Handle handle) const;
+  void Retain(Handle handle);
+  void Release(Handle handle);
+  void Collect();
+  std::size_t Size() const;
+  std::size_t Bytes() const;
+
+  // pools shared by all processes for their command lines and user names
+  static StringPool& Commands();
+  static StringPool& Users();
+
+ private:
+  std::size_t _chunkSize;
+  Arena _arena;
+  std::vector<std::string_view> _strings;
+  std::unordered_map<std::string_view, Handle> _handles;
+  std::vector<std::uint32_t> _references;  // per handle
+  std::vector<Handle> _released;  // reached 0 references, evicted by Collect
+  std::vector<Handle> _free;      // evicted, reused by Intern
+  std::size_t _liveBytes{0};
+  std::size_t _deadBytes{0};  // of evicted strings, until compacted
+};
+
+#endif
@@ -1,18 +1,39 @@
 #ifndef SYSTEM_H
 #define SYSTEM_H
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
+#include "history.h"
+#include "linux_parser.h"
+#include "numa.h"
 #include "process.h"
+#include "process_table.h"
 #include "processor.h"
+#include "snapshot.h"
 
 class System {
  public:
   System();
+  explicit System(SnapshotReader* source);
+  void Update(bool provisional = false);
+  void Watch(const std::vector<int>& pids);
+  void EnableNuma(std::size_t processes);
   Processor& Cpu(); 
+  float CpuUtilization() const;
+  const std::vector<float>& CoreUtilizations() const;
   std::vector<Process>& Processes();  
+  ProcessTable& Table();
   float MemoryUtilization();          
+  float MemoryAvailable() const;
+  float LoadAverage() const;
+  float WaitRate() const;
+  float SwitchRate() const;
+  float MinorFaultRate() const;
+  float MajorFaultRate() const;
+  const MetricHistory& History() const;
+  const Numa& NumaNodes() const;
   long UpTime();                      
   int TotalProcesses();               
   int RunningProcesses();             
@@ -22,10 +43,48 @@ class System {
  private:
   void removeProcesses();
   void addProcess();
+  void collect(bool provisional);
+  void readSnapshot();
+  void updateScheduling();
+  void sampleProcesses();
+  void updateProcesses(bool provisional);
   const std::string _os;
   const std::string _kernel;
   Processor _cpu = {};
-  std::vector<Process> _processes = {};
+  std::vector<Processor> _cores = {};
+  // buffers reused every tick
+  std::vector<std::vector<long>> _cpuJiffies = {};
+  std::vector<int> _cpuIds = {};  // per entry of _cpuJiffies
+  std::vector<int> _pids = {};
+  float _cpuUtilization{0};
+  std::vector<float> _coreUtilizations = {};
+  float _memoryUtilization{0};
+  float _memoryAvailable{0};
+  float _loadAverage{0};
+  long _upTime{0};
+  int _totalProcesses{0};
+  int _runningProcesses{0};
+  // scheduling counters of the previous tick and the rates since then
+  LinuxParser::SchedCounters _sched = {};
+  std::uint64_t _schedAt{0};
+  float _waitRate{-1};  // ms per second, -1 without /proc/schedstat
+  float _switchRate{0};
+  float _minorFaultRate{0};
+  float _majorFaultRate{0};
+  // pids sampled on top of the top processes, e.g. the visible rows
+  std::vector<int> _watched = {};
+  std::vector<int> _samplePids = {};
+  // attached to a publisher instead of reading /proc, not owned
+  SnapshotReader* _source{nullptr};
+  Snapshot::SystemRecord _snapshot = {};
+  std::vector<Process> _snapshotProcesses = {};
+  ProcessTable _table = {};
+  std::vector<int> _topRows = {};
+  MetricHistory _history = {};
+  // discovered and sampled only once enabled, never when attached
+  Numa _numa = {};
+  bool _numaEnabled{false};
+  std::size_t _numaProcesses{0};
 };
 
 #endif
\ No newline at end of file
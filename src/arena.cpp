@@ -0,0 +1,54 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+#include "arena.h"
+
+using std::size_t;
+
+/**
+ * @brief Construct Arena object, the first chunk is allocated on demand
+ *
+ * @param[in] chunkSize Size of each chunk in bytes
+ **/
+Arena::Arena(size_t chunkSize)
+: _chunkSize(chunkSize)
+{
+}
+
+/**
+ * @brief Return aligned memory which stays valid until the arena is gone
+ *
+ * @param[in] size      Number of bytes
+ * @param[in] alignment Alignment, power of two
+ **/
+void* Arena::Allocate(size_t size, size_t alignment)
+{
+    const auto padding = [&]()
+    {
+        const auto address = reinterpret_cast<std::uintptr_t>(_current);
+        return (alignment - address % alignment) % alignment;
+    };
+
+    if (_current == nullptr || padding() + size > _left)
+    {
+        // oversized requests get a chunk of their own
+        const size_t chunk = std::max(_chunkSize, size + alignment);
+        _chunks.emplace_back(new char[chunk]);
+        _current   = _chunks.back().get();
+        _left      = chunk;
+        _capacity += chunk;
+    }
+
+    const size_t skip = padding();
+    char* result = _current + skip;
+    _current    += skip + size;
+    _left       -= skip + size;
+    return result;
+}
+
+/**
+ * @brief Return number of bytes held in chunks
+ **/
+size_t Arena::Capacity() const { return _capacity; }
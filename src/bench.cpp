@@ -0,0 +1,345 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "bench.h"
+#include "exporter.h"
+#include "format.h"
+#include "linux_parser.h"
+#include "proc_reader.h"
+#include "process_table.h"
+#include "profiler.h"
+#include "rules.h"
+#include "string_pool.h"
+#include "system.h"
+
+using std::uint64_t;
+using std::vector;
+
+namespace {
+std::atomic<uint64_t> newCalls{0};
+
+uint64_t allocationCount() { return newCalls.load(std::memory_order_relaxed); }
+}  // namespace
+
+// Count every allocation done through operator new (containers, strings,
+// stream buffers) of the whole binary, the benchmark uses it to prove
+// allocation free ticks with and without MONITOR_PROFILING
+void* operator new(std::size_t size)
+{
+  newCalls.fetch_add(1, std::memory_order_relaxed);
+  if (void* memory = std::malloc(size == 0 ? 1 : size))
+  {
+    return memory;
+  }
+  throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) { return operator new(size); }
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete[](void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete[](void* memory, std::size_t) noexcept { std::free(memory); }
+
+namespace {
+uint64_t percentile(vector<uint64_t> values, int percent)
+{
+  if (values.empty())
+  {
+    return 0;
+  }
+  std::sort(values.begin(), values.end());
+  return values[(values.size() - 1) * percent / 100];
+}
+
+// Read stat and statm of all processes with one backend, returns false
+// if reads of a steady pid list allocate
+bool readBackend(ProcReader::Backend backend, const vector<int>& pids, int ticks)
+{
+  ProcReader reader;
+  if (backend == ProcReader::kUring_ && !reader.UseUring())
+  {
+    std::cout << "read " << ProcReader::Name(backend) << ": not available\n";
+    return true;
+  }
+  vector<ProcReader::Sample> samples;
+  reader.Read(pids, samples);
+
+  vector<uint64_t> durations;
+  durations.reserve(ticks);
+  const uint64_t syscalls    = reader.Syscalls();
+  const uint64_t allocations = allocationCount();
+  for (int i = 0; i < ticks; ++i)
+  {
+    const uint64_t start = Profiler::Now();
+    reader.Read(pids, samples);
+    durations.push_back(Profiler::Now() - start);
+  }
+  const uint64_t allocated = allocationCount() - allocations;
+
+  const auto valid = std::count_if(samples.begin(), samples.end(),
+                                   [](const ProcReader::Sample& s) { return s.valid; });
+  std::cout << "read " << ProcReader::Name(reader.Active()) << ": p50 "
+            << Format::Duration(percentile(durations, 50)) << ", p99 "
+            << Format::Duration(percentile(durations, 99)) << ", syscalls/tick "
+            << (reader.Syscalls() - syscalls) / ticks << ", valid " << valid << "/"
+            << pids.size() << "\n";
+  return allocated == 0;
+}
+
+// Time from a new System to the data of the first frame of the display:
+// a provisional tick, the default view and the users and commands of its
+// visible rows, compared with a complete first tick. Returns false if the
+// first frame misses its budget.
+bool firstFrame(int runs)
+{
+  const uint64_t kBudget = 50000000;  // ns
+  const std::size_t kVisible = 40;
+  vector<uint64_t> provisional, complete, second;
+  std::size_t processes = 0, pending = 0;
+  vector<int> rows, pids;
+  for (int i = 0; i < runs; ++i)
+  {
+    uint64_t start = Profiler::Now();
+    {
+      System system;
+      system.Update(true);
+      system.Table().Select(ProcessTable::View(), rows);
+      pids.clear();
+      for (std::size_t row = 0; row < std::min(kVisible, rows.size()); ++row)
+      {
+        pids.push_back(system.Processes()[rows[row]].Pid());
+      }
+      system.Table().Resolve(pids);
+      provisional.push_back(Profiler::Now() - start);
+      processes = system.Table().Size();
+      pending   = system.Table().Pending();
+
+      start = Profiler::Now();
+      system.Update();
+      second.push_back(Profiler::Now() - start);
+    }
+
+    start = Profiler::Now();
+    System system;
+    system.Update();
+    system.Table().Select(ProcessTable::View(), rows);
+    complete.push_back(Profiler::Now() - start);
+  }
+  const uint64_t p50 = percentile(provisional, 50);
+  std::cout << "first frame: p50 " << Format::Duration(p50) << " ("
+            << processes - pending << " of " << processes
+            << " processes resolved), complete first tick p50 "
+            << Format::Duration(percentile(complete, 50)) << ", second tick p50 "
+            << Format::Duration(percentile(second, 50)) << "\n";
+  return p50 <= kBudget;
+}
+
+// Evaluate 50 rules over a table of 50k synthetic processes, filled the
+// way an attached display fills it, returns false if evaluation allocates;
+// slow is set if an evaluation misses its budget
+bool evaluateRules(int ticks, bool& slow)
+{
+  const uint64_t kBudget = 1000000;  // ns, p50
+  const std::size_t kProcesses = 50000;
+  const char* const kRules[] = {
+    "process cpu > 90% for 30s", "process cpu >= 50%", "process ram > 16GB",
+    "process rss > 8GB for 1m", "process wait > 100ms", "process switches > 10000",
+    "process faults > 1000 for 10s", "user root cpu > 80%", "user root rss > 4GB",
+    "user nobody ram > 1GB for 5s"};
+  Rules rules;
+  std::string error;
+  for (std::size_t i = 0; rules.Program().size() < 50; ++i)
+  {
+    rules.Add(kRules[i % std::size(kRules)], error);
+  }
+
+  // deterministic values, about 5% of processes hold the cpu rule
+  vector<Process> processes;
+  processes.reserve(kProcesses);
+  const StringPool::Handle users[] = {StringPool::Users().Intern("root"),
+                                      StringPool::Users().Intern("nobody"),
+                                      StringPool::Users().Intern("bench")};
+  for (std::size_t i = 0; i < kProcesses; ++i)
+  {
+    Process::Record record{};
+    record.pid       = static_cast<int>(i + 1);
+    record.user      = users[i % std::size(users)];
+    record.cpu       = static_cast<float>((i * 7919) % 1000) / 950.0f;
+    record.recentCpu = record.cpu;
+    record.ram       = static_cast<int>((i * 104729) % 20000);
+    record.rss       = record.ram / 2;
+    record.waitRate  = static_cast<float>(i % 200);
+    processes.emplace_back(record);
+  }
+  ProcessTable table;
+  table.Update(processes);
+
+  // warm-up raises the events of all rules, measured ticks are steady
+  const std::uint32_t warmup = 3600;
+  rules.Evaluate(table, 1);
+  rules.Evaluate(table, warmup);
+  vector<uint64_t> durations;
+  durations.reserve(ticks);
+  std::size_t events = 0;
+  const uint64_t allocations = allocationCount();
+  for (int i = 0; i < ticks; ++i)
+  {
+    const uint64_t start = Profiler::Now();
+    rules.Evaluate(table, warmup + 1 + static_cast<std::uint32_t>(i));
+    durations.push_back(Profiler::Now() - start);
+    events += rules.Events().size();
+  }
+  const uint64_t allocated = allocationCount() - allocations;
+  const uint64_t p50 = percentile(durations, 50);
+  std::cout << "rules: " << rules.Program().size() << " rules x " << table.Size()
+            << " processes: p50 " << Format::Duration(p50)
+            << ", p99 " << Format::Duration(percentile(durations, 99))
+            << ", events " << events << "\n";
+  slow = p50 > kBudget;
+  return allocated == 0;
+}
+
+// Render the metrics of a sampled system while a scraper holds the previous
+// body, returns false if rendering allocates once both buffers exist
+bool renderMetrics(System& system, int ticks)
+{
+  Exporter exporter;
+  exporter.Render(system, Exporter::kDefaultTop);
+  std::shared_ptr<const std::string> held = exporter.Body();
+  exporter.Render(system, Exporter::kDefaultTop);
+
+  vector<uint64_t> durations;
+  durations.reserve(ticks);
+  const uint64_t allocations = allocationCount();
+  for (int i = 0; i < ticks; ++i)
+  {
+    held = exporter.Body();
+    const uint64_t start = Profiler::Now();
+    exporter.Render(system, Exporter::kDefaultTop);
+    durations.push_back(Profiler::Now() - start);
+  }
+  const uint64_t allocated = allocationCount() - allocations;
+
+  held = exporter.Body();
+  std::size_t series = 0;
+  for (std::size_t line = 0; line < held->size(); line = held->find('\n', line) + 1)
+  {
+    series += (*held)[line] != '#';
+  }
+  std::cout << "metrics: render p50 " << Format::Duration(percentile(durations, 50))
+            << ", p99 " << Format::Duration(percentile(durations, 99)) << ", "
+            << series << " series, " << held->size() << " bytes\n";
+  return allocated == 0;
+}
+}  // namespace
+
+/**
+ * @brief Run back to back ticks of System::Update and report their time
+ *        and allocations. Asserts that ticks without new processes do not
+ *        allocate, the first ticks are warm-up for the reused buffers.
+ *
+ * @param[in] ticks Number of measured ticks
+ * @return 0 if all assertions hold, 1 otherwise
+ **/
+int Bench::Run(int ticks)
+{
+  const int warmup = 2;
+  ticks = std::max(ticks, 1);
+  const bool firstFrameSlow = !firstFrame(5);
+
+  System system;
+  for (int i = 0; i < warmup; ++i)
+  {
+    system.Update();
+  }
+
+  // reserved up front, the loop itself must not allocate
+  vector<uint64_t> durations;
+  durations.reserve(ticks);
+  uint64_t steadyTicks = 0, steadyAllocations = 0, steadyMax = 0;
+  uint64_t churnTicks = 0, churnAllocations = 0;
+  for (int i = 0; i < ticks; ++i)
+  {
+    const uint64_t allocations = allocationCount();
+    const uint64_t start       = Profiler::Now();
+    system.Update();
+    durations.push_back(Profiler::Now() - start);
+    const uint64_t allocated   = allocationCount() - allocations;
+
+    // new processes are parsed and interned, which may allocate
+    if (system.Table().Added() == 0)
+    {
+      ++steadyTicks;
+      steadyAllocations += allocated;
+      steadyMax          = std::max(steadyMax, allocated);
+    }
+    else
+    {
+      ++churnTicks;
+      churnAllocations += allocated;
+    }
+  }
+
+  std::cout << "ticks: " << ticks << " (+" << warmup << " warm-up), processes: "
+            << system.Table().Size() << "\n";
+  std::cout << "tick time: p50 " << Format::Duration(percentile(durations, 50))
+            << ", p99 " << Format::Duration(percentile(durations, 99)) << "\n";
+
+  // per process reads of both backends over the same pids
+  vector<int> pids;
+  LinuxParser::Pids(pids);
+  bool readsAllocate = false;
+  for (const auto backend : {ProcReader::kSync_, ProcReader::kUring_})
+  {
+    readsAllocate = !readBackend(backend, pids, ticks) || readsAllocate;
+  }
+
+  bool rulesSlow = false;
+  const bool rulesAllocate = !evaluateRules(ticks, rulesSlow);
+  const bool metricsAllocate = !renderMetrics(system, ticks);
+
+  if (firstFrameSlow)
+  {
+    std::cout << "FAIL: first frame takes over 50ms\n";
+    return 1;
+  }
+  if (rulesSlow)
+  {
+    std::cout << "FAIL: evaluating rules takes over 1ms\n";
+    return 1;
+  }
+  std::cout << "allocations: " << steadyAllocations << " in " << steadyTicks
+            << " steady-state ticks (max " << steadyMax << "/tick), "
+            << churnAllocations << " in " << churnTicks
+            << " ticks with new processes\n";
+  if (steadyAllocations != 0)
+  {
+    std::cout << "FAIL: steady-state ticks allocate\n";
+    return 1;
+  }
+  if (readsAllocate)
+  {
+    std::cout << "FAIL: per process reads allocate\n";
+    return 1;
+  }
+  if (rulesAllocate)
+  {
+    std::cout << "FAIL: rule evaluation allocates\n";
+    return 1;
+  }
+  if (metricsAllocate)
+  {
+    std::cout << "FAIL: rendering metrics allocates\n";
+    return 1;
+  }
+  std::cout << "PASS: steady-state ticks do not allocate\n";
+  return 0;
+}
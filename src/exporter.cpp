@@ -0,0 +1,581 @@
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <csignal>
+#include <cstddef>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "exporter.h"
+#include "process.h"
+#include "string_pool.h"
+#include "system.h"
+
+using std::size_t;
+using std::string;
+using std::string_view;
+using std::vector;
+
+namespace {
+constexpr size_t kMaxConnections = 64;
+constexpr size_t kMaxRequest = 8192;
+constexpr size_t kMaxCommand = 128;  // bytes of the command label
+constexpr auto kIdleTimeout = std::chrono::seconds(5);
+
+std::atomic<bool> running{true};
+
+void stop(int) { running = false; }
+
+// shortest form that reads back the same value of its type
+template <typename T>
+void appendNumber(string& out, T value)
+{
+    char buffer[32];
+    const auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+    out.append(buffer, result.ptr - buffer);
+}
+
+// Label values escape backslash, double quote and newline, other control
+// characters of command lines are replaced by spaces
+void appendLabel(string& out, const char* name, string_view value)
+{
+    if (value.size() > kMaxCommand)
+    {
+        // cut before a UTF-8 continuation byte
+        size_t length = kMaxCommand;
+        while (length > 0 && (static_cast<unsigned char>(value[length]) & 0xc0) == 0x80)
+        {
+            --length;
+        }
+        value = value.substr(0, length);
+    }
+    out += name;
+    out += "=\"";
+    for (const char c : value)
+    {
+        switch (c)
+        {
+            case '\\': out += "\\\\"; break;
+            case '"':  out += "\\\""; break;
+            case '\n': out += "\\n"; break;
+            default:   out += (static_cast<unsigned char>(c) < 0x20) ? ' ' : c; break;
+        }
+    }
+    out += '"';
+}
+
+void family(string& out, const char* name, const char* type, const char* help)
+{
+    out += "# TYPE ";
+    out += name;
+    out += ' ';
+    out += type;
+    out += "\n# HELP ";
+    out += name;
+    out += ' ';
+    out += help;
+    out += '\n';
+}
+
+template <typename T>
+void sample(string& out, const char* name, T value)
+{
+    out += name;
+    out += ' ';
+    appendNumber(out, value);
+    out += '\n';
+}
+}  // namespace
+
+struct Exporter::Connection {
+    int fd{-1};
+    string request;
+    string header;  // status line, headers and an error body
+    std::shared_ptr<const string> body;
+    size_t sent{0};  // of header and body
+    bool responding{false};
+    std::chrono::steady_clock::time_point since;
+};
+
+/**
+ * @brief Close the listener, a Unix socket is removed
+ **/
+Exporter::~Exporter()
+{
+    if (_listen >= 0)
+    {
+        close(_listen);
+    }
+    if (!_path.empty())
+    {
+        unlink(_path.c_str());
+    }
+}
+
+/**
+ * @brief Listen on a local address
+ *
+ * @param[in] address "host:port" like "127.0.0.1:9273" or "[::1]:9273",
+ *                    or the path of a Unix socket starting with '/'; a
+ *                    stale socket at that path is replaced
+ * @return false on error, errno is set
+ **/
+bool Exporter::Open(const string& address)
+{
+    if (!address.empty() && address[0] == '/')
+    {
+        sockaddr_un local{};
+        local.sun_family = AF_UNIX;
+        if (address.size() >= sizeof(local.sun_path))
+        {
+            errno = ENAMETOOLONG;
+            return false;
+        }
+        std::memcpy(local.sun_path, address.c_str(), address.size() + 1);
+        struct stat status;
+        if (lstat(address.c_str(), &status) == 0 && S_ISSOCK(status.st_mode))
+        {
+            unlink(address.c_str());
+        }
+        _listen = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (_listen < 0 ||
+            bind(_listen, reinterpret_cast<const sockaddr*>(&local), sizeof(local)) != 0 ||
+            listen(_listen, SOMAXCONN) != 0)
+        {
+            return false;
+        }
+        _path = address;
+        return true;
+    }
+
+    const size_t colon = address.rfind(':');
+    if (colon == string::npos)
+    {
+        errno = EINVAL;
+        return false;
+    }
+    string host = address.substr(0, colon);
+    const string port = address.substr(colon + 1);
+    if (host.size() >= 2 && host.front() == '[' && host.back() == ']')
+    {
+        host = host.substr(1, host.size() - 2);
+    }
+    addrinfo hints{};
+    hints.ai_family   = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags    = AI_NUMERICSERV;
+    addrinfo* found = nullptr;
+    if (getaddrinfo(host.empty() ? "127.0.0.1" : host.c_str(), port.c_str(), &hints, &found) != 0)
+    {
+        errno = EINVAL;
+        return false;
+    }
+    for (addrinfo* candidate = found; candidate != nullptr; candidate = candidate->ai_next)
+    {
+        const int fd = socket(candidate->ai_family,
+                              candidate->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (fd < 0)
+        {
+            continue;
+        }
+        const int reuse = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        if (bind(fd, candidate->ai_addr, candidate->ai_addrlen) == 0 && listen(fd, SOMAXCONN) == 0)
+        {
+            _listen = fd;
+            break;
+        }
+        const int error = errno;
+        close(fd);
+        errno = error;
+    }
+    freeaddrinfo(found);
+    return _listen >= 0;
+}
+
+/**
+ * @brief Render the latest Update of a system as the body served from now
+ *        on. Scrapers still sending the previous body keep it alive, its
+ *        buffer is reused once they are done.
+ *
+ * @param[in] system Sampled system
+ * @param[in] top    Max number of processes with per process series
+ **/
+void Exporter::Render(System& system, size_t top)
+{
+    std::shared_ptr<string> buffer;
+    for (const auto& candidate : _buffers)
+    {
+        // only the pool holds it: neither current nor sent to a scraper
+        if (candidate.use_count() == 1)
+        {
+            // use_count is a relaxed load; pairs with the release of the
+            // server thread's last reference, so its reads of the body
+            // happen before the buffer is overwritten
+            std::atomic_thread_fence(std::memory_order_acquire);
+            buffer = candidate;
+            break;
+        }
+    }
+    if (!buffer)
+    {
+        buffer = std::make_shared<string>();
+        _buffers.push_back(buffer);
+    }
+    string& out = *buffer;
+    out.clear();
+
+    family(out, "monitor_cpu_ratio", "gauge", "Share of time all cpus were busy since the previous tick.");
+    sample(out, "monitor_cpu_ratio", system.CpuUtilization());
+    family(out, "monitor_core_cpu_ratio", "gauge", "Share of time a cpu was busy since the previous tick.");
+    const vector<float>& cores = system.CoreUtilizations();
+    for (size_t core = 0; core < cores.size(); ++core)
+    {
+        out += "monitor_core_cpu_ratio{core=\"";
+        appendNumber(out, core);
+        out += "\"} ";
+        appendNumber(out, cores[core]);
+        out += '\n';
+    }
+    family(out, "monitor_memory_used_ratio", "gauge", "Share of memory not free.");
+    sample(out, "monitor_memory_used_ratio", system.MemoryUtilization());
+    family(out, "monitor_memory_available_ratio", "gauge", "Share of memory available without swapping.");
+    sample(out, "monitor_memory_available_ratio", system.MemoryAvailable());
+    family(out, "monitor_load1", "gauge", "Load average over one minute.");
+    sample(out, "monitor_load1", system.LoadAverage());
+    family(out, "monitor_uptime_seconds", "gauge", "Time since boot.");
+    sample(out, "monitor_uptime_seconds", system.UpTime());
+    family(out, "monitor_forks", "counter", "Processes created since boot.");
+    sample(out, "monitor_forks_total", system.TotalProcesses());
+    family(out, "monitor_processes_running", "gauge", "Processes running or runnable.");
+    sample(out, "monitor_processes_running", system.RunningProcesses());
+    if (system.WaitRate() >= 0)
+    {
+        family(out, "monitor_run_queue_wait_seconds_per_second", "gauge",
+               "Time all tasks waited on run queues per second.");
+        sample(out, "monitor_run_queue_wait_seconds_per_second", system.WaitRate() / 1000.0f);
+    }
+    family(out, "monitor_context_switches_per_second", "gauge", "Context switches per second.");
+    sample(out, "monitor_context_switches_per_second", system.SwitchRate());
+    family(out, "monitor_page_faults_per_second", "gauge", "Page faults per second.");
+    out += "monitor_page_faults_per_second{kind=\"minor\"} ";
+    appendNumber(out, system.MinorFaultRate());
+    out += "\nmonitor_page_faults_per_second{kind=\"major\"} ";
+    appendNumber(out, system.MajorFaultRate());
+    out += '\n';
+
+    // per process series for the top processes by cpu only
+    const vector<Process>& processes = system.Processes();
+    system.Table().Top(top, _rows);
+    family(out, "monitor_processes", "gauge", "Processes known to the monitor.");
+    sample(out, "monitor_processes", processes.size());
+    family(out, "monitor_processes_exported", "gauge", "Processes with per process series, the top by cpu.");
+    sample(out, "monitor_processes_exported", _rows.size());
+
+    const StringPool& users    = StringPool::Users();
+    const StringPool& commands = StringPool::Commands();
+    // rates are left out for processes not sampled this tick rather than
+    // reported as 0, e.g. right after they entered the top
+    const auto series = [&](const char* name, const char* kind, bool rate, auto value)
+    {
+        for (const int row : _rows)
+        {
+            const Process& process = processes[row];
+            if (rate && !process.Rated())
+            {
+                continue;
+            }
+            out += name;
+            out += "{pid=\"";
+            appendNumber(out, process.Pid());
+            out += "\",";
+            appendLabel(out, "user", users.Get(process.UserHandle()));
+            out += ',';
+            appendLabel(out, "command", commands.Get(process.CommandHandle()));
+            if (kind != nullptr)
+            {
+                out += ",kind=\"";
+                out += kind;
+                out += '"';
+            }
+            out += "} ";
+            appendNumber(out, value(process));
+            out += '\n';
+        }
+    };
+    family(out, "monitor_process_cpu_ratio", "gauge", "Share of one cpu used over the lifetime of a process.");
+    series("monitor_process_cpu_ratio", nullptr, false, [](const Process& p) { return p.CpuUtilization(); });
+    family(out, "monitor_process_virtual_memory_bytes", "gauge", "Virtual memory size of a process.");
+    series("monitor_process_virtual_memory_bytes", nullptr, false, [](const Process& p) { return static_cast<long>(p.Ram()) << 20; });
+    family(out, "monitor_process_resident_memory_bytes", "gauge", "Resident memory of a process.");
+    series("monitor_process_resident_memory_bytes", nullptr, false, [](const Process& p) { return static_cast<long>(p.Rss()) << 20; });
+    family(out, "monitor_process_uptime_seconds", "gauge", "Time since a process started.");
+    series("monitor_process_uptime_seconds", nullptr, false, [](const Process& p) { return p.UpTime(); });
+    family(out, "monitor_process_run_queue_wait_seconds_per_second", "gauge",
+           "Time a process waited on a run queue per second.");
+    series("monitor_process_run_queue_wait_seconds_per_second", nullptr, true,
+           [](const Process& p) { return p.WaitRate() / 1000.0f; });
+    family(out, "monitor_process_context_switches_per_second", "gauge", "Context switches of a process per second.");
+    series("monitor_process_context_switches_per_second", "voluntary", true,
+           [](const Process& p) { return p.VoluntarySwitchRate(); });
+    series("monitor_process_context_switches_per_second", "involuntary", true,
+           [](const Process& p) { return p.InvoluntarySwitchRate(); });
+    family(out, "monitor_process_page_faults_per_second", "gauge", "Page faults of a process per second.");
+    series("monitor_process_page_faults_per_second", "minor", true,
+           [](const Process& p) { return p.MinorFaultRate(); });
+    series("monitor_process_page_faults_per_second", "major", true,
+           [](const Process& p) { return p.MajorFaultRate(); });
+    out += "# EOF\n";
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _current = buffer;
+}
+
+/**
+ * @brief Return the body of the latest Render, nullptr before the first
+ **/
+std::shared_ptr<const string> Exporter::Body() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _current;
+}
+
+/**
+ * @brief Serve scrapers until SIGINT or SIGTERM, meant for its own thread.
+ *        Requests are read and responses written without blocking, so a
+ *        slow scraper does not hold up the others.
+ **/
+void Exporter::Run()
+{
+    vector<Connection> connections;
+    vector<pollfd> fds;
+    while (running)
+    {
+        fds.clear();
+        fds.push_back({_listen, POLLIN, 0});
+        for (const auto& connection : connections)
+        {
+            fds.push_back({connection.fd, static_cast<short>(connection.responding ? POLLOUT : POLLIN), 0});
+        }
+        // short timeout, so a signal is handled quickly
+        if (poll(fds.data(), fds.size(), 100) < 0 && errno != EINTR)
+        {
+            break;
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < connections.size(); ++i)
+        {
+            Connection& connection = connections[i];
+            bool open = now - connection.since < kIdleTimeout;
+            if (open && !connection.responding && fds[i + 1].revents != 0)
+            {
+                char chunk[1024];
+                const ssize_t length = recv(connection.fd, chunk, sizeof(chunk), 0);
+                if (length > 0)
+                {
+                    connection.request.append(chunk, length);
+                    if (connection.request.find("\r\n\r\n") != string::npos)
+                    {
+                        open = respond(connection);
+                    }
+                    open = open && connection.request.size() <= kMaxRequest;
+                }
+                else
+                {
+                    open = length < 0 && (errno == EAGAIN || errno == EWOULDBLOCK);
+                }
+            }
+            if (open && connection.responding)
+            {
+                // header and the rest of the body in one call
+                const size_t header = connection.header.size();
+                const size_t body   = connection.body ? connection.body->size() : 0;
+                iovec parts[2];
+                size_t count = 0;
+                if (connection.sent < header)
+                {
+                    parts[count++] = {connection.header.data() + connection.sent, header - connection.sent};
+                }
+                const size_t offset = std::max(connection.sent, header) - header;
+                if (offset < body)
+                {
+                    parts[count++] = {const_cast<char*>(connection.body->data()) + offset, body - offset};
+                }
+                msghdr message{};
+                message.msg_iov    = parts;
+                message.msg_iovlen = count;
+                const ssize_t length = (count > 0) ? sendmsg(connection.fd, &message, MSG_NOSIGNAL) : 0;
+                if (length >= 0)
+                {
+                    connection.sent += length;
+                    open = connection.sent < header + body;
+                }
+                else
+                {
+                    open = errno == EAGAIN || errno == EWOULDBLOCK;
+                }
+            }
+            if (!open)
+            {
+                close(connection.fd);
+                connection.fd = -1;
+            }
+        }
+        connections.erase(std::remove_if(connections.begin(), connections.end(),
+                                         [](const Connection& c) { return c.fd < 0; }),
+                          connections.end());
+
+        if ((fds[0].revents & POLLIN) != 0)
+        {
+            int fd;
+            while ((fd = accept4(_listen, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0)
+            {
+                if (connections.size() >= kMaxConnections)
+                {
+                    close(fd);
+                    continue;
+                }
+                Connection connection;
+                connection.fd    = fd;
+                connection.since = now;
+                connections.push_back(std::move(connection));
+            }
+        }
+    }
+    for (const auto& connection : connections)
+    {
+        close(connection.fd);
+    }
+}
+
+/**
+ * @brief Collect once per second and render every tick while a server
+ *        thread answers scrapers, until SIGINT or SIGTERM
+ *
+ * @param[in] system  Collecting or attached system
+ * @param[in] address Address to listen on, see Open
+ * @param[in] top     Max number of processes with per process series
+ * @return process exit code
+ **/
+int Exporter::Serve(System& system, const string& address, size_t top)
+{
+    Exporter exporter;
+    if (!exporter.Open(address))
+    {
+        std::cerr << "monitor: cannot listen on " << address << ": "
+                  << std::strerror(errno) << "\n";
+        return 1;
+    }
+    std::signal(SIGINT, stop);
+    std::signal(SIGTERM, stop);
+
+    // the exported processes get their rates sampled the next ticks
+    vector<int> exported;
+    const auto watch = [&]()
+    {
+        exported.clear();
+        for (const int row : exporter._rows)
+        {
+            exported.push_back(system.Processes()[row].Pid());
+        }
+        system.Watch(exported);
+    };
+
+    system.Update();
+    exporter.Render(system, top);
+    watch();
+    std::thread server(&Exporter::Run, &exporter);
+
+    auto next = std::chrono::steady_clock::now();
+    while (running)
+    {
+        next += std::chrono::seconds(1);
+        // short sleeps, so a signal is handled quickly
+        while (running && std::chrono::steady_clock::now() < next)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+        if (running)
+        {
+            system.Update();
+            exporter.Render(system, top);
+            watch();
+        }
+    }
+    server.join();
+    return 0;
+}
+
+/**
+ * @brief Prepare the response to a complete request: the latest body for
+ *        GET /metrics, an error otherwise
+ *
+ * @return false if the connection should be closed right away
+ **/
+bool Exporter::respond(Connection& connection)
+{
+    const string_view request(connection.request);
+    const string_view line = request.substr(0, request.find("\r\n"));
+    const size_t space     = line.find(' ');
+    const string_view method = line.substr(0, space);
+    string_view target = (space == string_view::npos) ? string_view() : line.substr(space + 1);
+    target = target.substr(0, target.find(' '));
+    target = target.substr(0, target.find('?'));
+
+    const char* status = "200 OK";
+    const char* error  = nullptr;
+    if (method != "GET" && method != "HEAD")
+    {
+        status = "405 Method Not Allowed";
+        error  = "only GET is supported\n";
+    }
+    else if (target != "/metrics" && target != "/")
+    {
+        status = "404 Not Found";
+        error  = "metrics are served at /metrics\n";
+    }
+    else
+    {
+        connection.body = Body();
+    }
+    if (connection.body && method == "HEAD")
+    {
+        // same headers as GET, no body
+        const size_t length = connection.body->size();
+        connection.body.reset();
+        connection.header = string("HTTP/1.1 200 OK\r\n") +
+            "Content-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n"
+            "Content-Length: " + std::to_string(length) + "\r\nConnection: close\r\n\r\n";
+    }
+    else if (connection.body)
+    {
+        connection.header = string("HTTP/1.1 ") + status + "\r\n"
+            "Content-Type: application/openmetrics-text; version=1.0.0; charset=utf-8\r\n"
+            "Content-Length: " + std::to_string(connection.body->size()) +
+            "\r\nConnection: close\r\n\r\n";
+    }
+    else
+    {
+        const string text = error ? error : "no snapshot yet\n";
+        connection.header = string("HTTP/1.1 ") + (error ? status : "503 Service Unavailable") +
+            "\r\nContent-Type: text/plain; charset=utf-8\r\nContent-Length: " +
+            std::to_string(text.size()) + "\r\nConnection: close\r\n\r\n" + text;
+    }
+    connection.responding = true;
+    return true;
+}
@@ -38,8 +38,8 @@ string Format::ElapsedTime(long seconds)
  **/
 string Format::Ram(int ram) 
 {  
-    char ramBuffer[8];
-    sprintf(ramBuffer, "%7d", ram);
+    char ramBuffer[12];
+    snprintf(ramBuffer, sizeof(ramBuffer), "%7d", ram);
     return string(ramBuffer); 
 }
 
@@ -53,8 +53,8 @@ string Format::Ram(int ram)
  **/
 string Format::Pid(int pid)
 {
-    char pidBuffer[7];
-    sprintf(pidBuffer, "%6d", pid);
+    char pidBuffer[12];
+    snprintf(pidBuffer, sizeof(pidBuffer), "%6d", pid);
     return string(pidBuffer); 
 }
 
@@ -66,13 +66,70 @@ string Format::Pid(int pid)
  *        after sorting we get weird output with values overlapping 
  * 
  * @param[in] command Not formatted command string 
- * @param[in] maxSize Max size left in column        
- * @return Formatted command as string 
+ * @param[in] maxSize Max size left in column, may be 0 or negative        
+ * @return Formatted command as string, padded to maxSize - 1 characters 
  **/
 string Format::Command(string command, int maxSize)
 {
-    char pidBuffer[maxSize];
-    string format = "%-" + std::to_string(maxSize-1)+ "s";
-    sprintf(pidBuffer, format.c_str(), command.substr(0, maxSize).c_str());
-    return string(pidBuffer); 
-}
\ No newline at end of file
+    // one column is kept free for the window border, nothing fits below 2
+    command.resize((maxSize > 1) ? maxSize - 1 : 0, ' ');
+    return command; 
+}
+
+/**
+ * @brief Format a duration to a short human readable string
+ *        like "850ns", "12.4us" or "3.1ms"
+ * 
+ * @param[in] nanoseconds Duration in ns 
+ * @return Formatted duration as string 
+ **/
+string Format::Duration(std::uint64_t nanoseconds)
+{
+    char durationBuffer[16];
+    if (nanoseconds < 1000)
+    {
+        snprintf(durationBuffer, sizeof(durationBuffer), "%lluns", static_cast<unsigned long long>(nanoseconds));
+    }
+    else if (nanoseconds < 1000000)
+    {
+        snprintf(durationBuffer, sizeof(durationBuffer), "%.1fus", nanoseconds / 1e3);
+    }
+    else if (nanoseconds < 1000000000)
+    {
+        snprintf(durationBuffer, sizeof(durationBuffer), "%.1fms", nanoseconds / 1e6);
+    }
+    else
+    {
+        snprintf(durationBuffer, sizeof(durationBuffer), "%.1fs", nanoseconds / 1e9);
+    }
+    return string(durationBuffer);
+}
+
+/**
+ * @brief Format a rate to at most 5 characters like "0.3", "12",
+ *        "4.5k" or "120M"
+ * 
+ * @param[in] perSecond Rate 
+ * @return Formatted rate as string 
+ **/
+string Format::Rate(float perSecond)
+{
+    char rateBuffer[16];
+    if (perSecond < 10)
+    {
+        snprintf(rateBuffer, sizeof(rateBuffer), "%.1f", perSecond);
+    }
+    else if (perSecond < 1e4f)
+    {
+        snprintf(rateBuffer, sizeof(rateBuffer), "%.0f", perSecond);
+    }
+    else if (perSecond < 1e7f)
+    {
+        snprintf(rateBuffer, sizeof(rateBuffer), "%.1fk", perSecond / 1e3f);
+    }
+    else
+    {
+        snprintf(rateBuffer, sizeof(rateBuffer), "%.0fM", perSecond / 1e6f);
+    }
+    return string(rateBuffer);
+}
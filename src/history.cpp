@@ -0,0 +1,255 @@
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "history.h"
+#include "process.h"
+
+using std::size_t;
+using std::vector;
+
+/**
+ * @brief Construct TimeSeries object, all buffers are allocated here
+ *
+ * @param[in] resolutions List of (step, capacity) pairs, finest first
+ **/
+TimeSeries::TimeSeries(std::initializer_list<Resolution> resolutions)
+{
+    for (const auto& resolution : resolutions)
+    {
+        Tier tier;
+        tier.step     = std::max<size_t>(resolution.step, 1);
+        tier.capacity = std::max<size_t>(resolution.capacity, 1);
+        tier.avg.resize(tier.capacity);
+        tier.min.resize(tier.capacity);
+        tier.max.resize(tier.capacity);
+        _tiers.push_back(std::move(tier));
+    }
+}
+
+/**
+ * @brief Append a raw sample, coarser resolutions get a new point
+ *        every step samples
+ *
+ * @param[in] value Sampled value
+ **/
+void TimeSeries::Append(float value)
+{
+    for (auto& tier : _tiers)
+    {
+        if (tier.pendingCount == 0)
+        {
+            tier.pendingSum = 0;
+            tier.pendingMin = value;
+            tier.pendingMax = value;
+        }
+        tier.pendingSum += value;
+        tier.pendingMin  = std::min(tier.pendingMin, value);
+        tier.pendingMax  = std::max(tier.pendingMax, value);
+
+        if (++tier.pendingCount < tier.step)
+        {
+            continue;
+        }
+
+        // ring buffer: overwrite the oldest point when full
+        tier.avg[tier.head] = tier.pendingSum / static_cast<float>(tier.step);
+        tier.min[tier.head] = tier.pendingMin;
+        tier.max[tier.head] = tier.pendingMax;
+        tier.head           = (tier.head + 1) % tier.capacity;
+        tier.size           = std::min(tier.size + 1, tier.capacity);
+        tier.pendingCount   = 0;
+    }
+}
+
+/**
+ * @brief Drop all points, the buffers are kept
+ **/
+void TimeSeries::Clear()
+{
+    for (auto& tier : _tiers)
+    {
+        tier.head         = 0;
+        tier.size         = 0;
+        tier.pendingCount = 0;
+    }
+}
+
+/**
+ * @brief Return number of points stored in a resolution
+ **/
+size_t TimeSeries::Size(size_t tier) const
+{
+    return (tier < _tiers.size()) ? _tiers[tier].size : 0;
+}
+
+/**
+ * @brief Copy the latest averaged points, oldest first
+ *
+ * @param[in]  n      Max number of points
+ * @param[out] values Receives the points
+ * @param[in]  tier   Index of resolution
+ **/
+void TimeSeries::Recent(size_t n, vector<float>& values, size_t tier) const
+{
+    values.clear();
+    if (tier >= _tiers.size())
+    {
+        return;
+    }
+    const Tier& t     = _tiers[tier];
+    const size_t count = std::min(n, t.size);
+    for (size_t i = count; i > 0; --i)
+    {
+        values.push_back(t.avg[(t.head + t.capacity - i) % t.capacity]);
+    }
+}
+
+/**
+ * @brief Return min/avg/max over the latest points of a resolution
+ *
+ * @param[in] n    Max number of points
+ * @param[in] tier Index of resolution
+ **/
+TimeSeries::Summary TimeSeries::Summarize(size_t n, size_t tier) const
+{
+    Summary summary;
+    if (tier >= _tiers.size() || _tiers[tier].size == 0)
+    {
+        return summary;
+    }
+    const Tier& t      = _tiers[tier];
+    const size_t count = std::min(n, t.size);
+    float sum          = 0;
+    summary.min        = t.min[(t.head + t.capacity - 1) % t.capacity];
+    summary.max        = summary.min;
+    for (size_t i = count; i > 0; --i)
+    {
+        const size_t k = (t.head + t.capacity - i) % t.capacity;
+        summary.min    = std::min(summary.min, t.min[k]);
+        summary.max    = std::max(summary.max, t.max[k]);
+        sum           += t.avg[k];
+    }
+    summary.avg = sum / static_cast<float>(count);
+    return summary;
+}
+
+/**
+ * @brief Construct MetricHistory object with empty process slots
+ **/
+MetricHistory::MetricHistory()
+: _processes(kTopProcesses)
+{
+}
+
+/**
+ * @brief Append one sample of every system metric
+ *
+ * @param[in] cpu    Aggregated cpu utilization
+ * @param[in] cores  Utilization per core
+ * @param[in] memory Memory utilization
+ * @param[in] load   Load average of the last minute
+ **/
+void MetricHistory::RecordSystem(float cpu, const vector<float>& cores,
+                                 float memory, float load)
+{
+    _cpu.Append(cpu);
+    // number of cores is known after the first sample
+    if (_cores.size() != cores.size())
+    {
+        _cores.assign(cores.size(), TimeSeries());
+    }
+    for (size_t i = 0; i < cores.size(); ++i)
+    {
+        _cores[i].Append(cores[i]);
+    }
+    _memory.Append(memory);
+    _load.Append(load);
+}
+
+/**
+ * @brief Append one sample for the top processes, slots of processes
+ *        which left the top are reused
+ *
+ * @param[in] processes All processes
+ * @param[in] top       Rows of the top processes in processes
+ **/
+void MetricHistory::RecordProcesses(const vector<Process>& processes,
+                                    const vector<int>& top)
+{
+    const size_t count = std::min(kTopProcesses, top.size());
+    const auto isTop = [&](int pid)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (processes[top[i]].Pid() == pid)
+            {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    for (auto& slot : _processes)
+    {
+        if (slot.pid != -1 && !isTop(slot.pid))
+        {
+            slot.pid = -1;
+            slot.cpu.Clear();
+            slot.ram.Clear();
+        }
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const auto& process = processes[top[i]];
+        auto slot = std::find_if(_processes.begin(), _processes.end(),
+            [&](const ProcessSlot& s) { return s.pid == process.Pid(); });
+        if (slot == _processes.end())
+        {
+            slot = std::find_if(_processes.begin(), _processes.end(),
+                [](const ProcessSlot& s) { return s.pid == -1; });
+            slot->pid = process.Pid();
+        }
+        slot->cpu.Append(process.RecentCpuUtilization());
+        slot->ram.Append(static_cast<float>(process.Ram()));
+    }
+}
+
+/**
+ * @brief Return history of the aggregated cpu utilization
+ **/
+const TimeSeries& MetricHistory::Cpu() const { return _cpu; }
+
+/**
+ * @brief Return history of the utilization per core
+ **/
+const vector<TimeSeries>& MetricHistory::Cores() const { return _cores; }
+
+/**
+ * @brief Return history of the memory utilization
+ **/
+const TimeSeries& MetricHistory::Memory() const { return _memory; }
+
+/**
+ * @brief Return history of the load average
+ **/
+const TimeSeries& MetricHistory::Load() const { return _load; }
+
+/**
+ * @brief Return cpu history of a top process
+ *
+ * @param[in] pid Process id
+ * @return pointer to history, nullptr if process is not in the top
+ **/
+const TimeSeries* MetricHistory::ProcessCpu(int pid) const
+{
+    for (const auto& slot : _processes)
+    {
+        if (slot.pid == pid)
+        {
+            return &slot.cpu;
+        }
+    }
+    return nullptr;
+}
@@ -1,18 +1,115 @@
+#include "field_table.h"
 #include "linux_parser.h"
+#include "profiler.h"
 
 #include <dirent.h>
+#include <fcntl.h>
+#include <sys/syscall.h>
 #include <unistd.h>
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <iterator>
+#include <sstream>
 #include <string>
+#include <string_view>
 #include <vector>
 
 using std::stof;
 using std::string;
+using std::string_view;
 using std::to_string;
 using std::vector;
 
+// buffer shared by the parsers below, it grows to the largest file once
+static thread_local vector<char> fileBuffer;
+// open/read/close calls issued by this thread
+static thread_local std::uint64_t syscalls = 0;
+
+/**
+ * @brief Read a whole file into the shared buffer, no allocation
+ *        happens once the buffer is large enough
+ * @param[in] filePath Full path to file which should be read in
+ * 
+ * @return Content of file, valid until the next call; empty on error
+ **/
+static string_view readFile(const char* filePath)
+{
+  const int fd = open(filePath, O_RDONLY | O_CLOEXEC);
+  ++syscalls;
+  if (fd < 0)
+  {
+    return {};
+  }
+  size_t length = 0;
+  while (true)
+  {
+    if (length == fileBuffer.size())
+    {
+      fileBuffer.resize(std::max<size_t>(4096, 2 * fileBuffer.size()));
+    }
+    const ssize_t count = read(fd, fileBuffer.data() + length, fileBuffer.size() - length);
+    ++syscalls;
+    if (count <= 0)
+    {
+      break;
+    }
+    length += count;
+  }
+  close(fd);
+  ++syscalls;
+  return string_view(fileBuffer.data(), length);
+}
+
+/**
+ * @brief Build the path of a file in a process directory without allocating
+ * @param[out] buffer   Receives the path
+ * @param[in]  size     Size of buffer
+ * @param[in]  pid      Process id
+ * @param[in]  fileName File name like kStatFilename
+ * 
+ * @return buffer
+ **/
+static const char* pidPath(char* buffer, size_t size, int pid, const string& fileName)
+{
+  snprintf(buffer, size, "%s%d%s", LinuxParser::kProcDirectory.c_str(), pid, fileName.c_str());
+  return buffer;
+}
+
+/**
+ * @brief Parse a number at the start of text, leading blanks are skipped
+ * @param[in]  text  Text to parse
+ * @param[out] value Parsed number, unchanged on error
+ * 
+ * @return Rest of text behind the number
+ **/
+template <typename T>
+string_view parseNumber(string_view text, T& value)
+{
+  size_t start = 0;
+  while (start < text.size() && (text[start] == ' ' || text[start] == '\t'))
+  {
+    ++start;
+  }
+  const auto result = std::from_chars(text.data() + start, text.data() + text.size(), value);
+  return text.substr(result.ptr - text.data());
+}
+
+/**
+ * @brief Convert a number of pages to mb, rounded
+ **/
+static int pagesToMB(long pages)
+{
+  static const long pageSize = sysconf(_SC_PAGESIZE);
+  return static_cast<int>(pages * pageSize / (1024.0 * 1024.0) + 0.5);
+}
+
 
 /**
  * @brief Read a value for the appropriated key from a file
+ *        Lines look like "key value" or "key: value"
  * @param[in] filePath Full path to file which should be read in
  * @param[in] searchedKey Key for which should be read value 
  * @param[in] defaultVaL  Default value if key not found   
@@ -20,28 +117,26 @@ using std::vector;
  * @return A value for the appropriated key in file, if not found return default
  **/
 template <typename T>
-T readValueFromFile(const string& filePath, const string& searchedKey, T defaultVal)
+T readValueFromFile(const char* filePath, const string& searchedKey, T defaultVal)
 {
   T value = defaultVal;
-  string key, line;
-  std::ifstream fileStream(filePath);
-  if (fileStream.is_open()) 
+  string_view content = readFile(filePath);
+  while (!content.empty())
   {
-    while (std::getline(fileStream, line))
+    const size_t end = std::min(content.find('\n'), content.size());
+    string_view line = content.substr(0, end);
+    content.remove_prefix(std::min(end + 1, content.size()));
+
+    if (line.size() > searchedKey.size() &&
+        line.compare(0, searchedKey.size(), searchedKey) == 0 &&
+        (line[searchedKey.size()] == ':' || std::isspace(line[searchedKey.size()])))
     {
-      // remove some separators 
-      std::replace(line.begin(), line.end(), ':', ' ');
-      
-      std::istringstream lineStream(line);
-      lineStream >> key;
-      if (key == searchedKey)
-      {
-        lineStream >> value; 
-        break;
-      }
+      // remove separator
+      line.remove_prefix(searchedKey.size() + (line[searchedKey.size()] == ':'));
+      parseNumber(line, value);
+      break;
     }
   }
-  fileStream.close();
   return value;
 }
 
@@ -83,24 +178,129 @@ string LinuxParser::Kernel() {
   return kernel;
 }
 
-// BONUS: Update this to use std::filesystem
 vector<int> LinuxParser::Pids() {
   vector<int> pids;
-  DIR* directory = opendir(kProcDirectory.c_str());
-  struct dirent* file;
-  while ((file = readdir(directory)) != nullptr) {
-    // Is this a directory?
-    if (file->d_type == DT_DIR) {
+  Pids(pids);
+  return pids;
+}
+
+/**
+ * @brief Read the ids of all processes into a reused vector
+ *        Directory entries are read with getdents64 into a stack buffer,
+ *        so nothing is allocated once pids has enough capacity
+ * 
+ * @param[out] pids Receives the process ids
+ **/
+void LinuxParser::Pids(vector<int>& pids) {
+  pids.clear();
+  const int directory = open(kProcDirectory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+  if (directory < 0) {
+    return;
+  }
+  alignas(dirent64) char buffer[32 * 1024];
+  long length;
+  while ((length = syscall(SYS_getdents64, directory, buffer, sizeof(buffer))) > 0) {
+    for (long offset = 0; offset < length;) {
+      const auto* file = reinterpret_cast<const dirent64*>(buffer + offset);
+      offset += file->d_reclen;
+      // Is this a directory?
+      if (file->d_type != DT_DIR) {
+        continue;
+      }
       // Is every character of the name a digit?
-      string filename(file->d_name);
-      if (std::all_of(filename.begin(), filename.end(), isdigit)) {
-        int pid = stoi(filename);
+      int pid = 0;
+      const char* c = file->d_name;
+      for (; std::isdigit(*c); ++c) {
+        pid = pid * 10 + (*c - '0');
+      }
+      if (*c == '\0' && c != file->d_name) {
         pids.push_back(pid);
       }
     }
   }
-  closedir(directory);
-  return pids;
+  close(directory);
+}
+
+// keys of /proc/meminfo, all of them are within the first lines
+constexpr Field<LinuxParser::MemInfo> meminfoFields[] = {
+  {"MemTotal", &LinuxParser::MemInfo::total},
+  {"MemFree", &LinuxParser::MemInfo::free},
+  {"MemAvailable", &LinuxParser::MemInfo::available},
+  {"Buffers", &LinuxParser::MemInfo::buffers},
+  {"Cached", &LinuxParser::MemInfo::cached},
+  {"SwapTotal", &LinuxParser::MemInfo::swapTotal},
+  {"SwapFree", &LinuxParser::MemInfo::swapFree}};
+constexpr FieldTable meminfoTable(meminfoFields);
+static_assert(meminfoTable.Perfect(), "meminfo keys collide, change the hash");
+
+// keys of /proc/<pid>/status
+constexpr Field<LinuxParser::ProcStatus> statusFields[] = {
+  {"Uid", &LinuxParser::ProcStatus::uid},
+  {"VmRSS", &LinuxParser::ProcStatus::vmRss},
+  {"VmSwap", &LinuxParser::ProcStatus::vmSwap},
+  {"Threads", &LinuxParser::ProcStatus::threads},
+  {"voluntary_ctxt_switches", &LinuxParser::ProcStatus::voluntarySwitches},
+  {"nonvoluntary_ctxt_switches", &LinuxParser::ProcStatus::involuntarySwitches}};
+constexpr FieldTable statusTable(statusFields);
+static_assert(statusTable.Perfect(), "status keys collide, change the hash");
+
+// keys of /proc/vmstat
+constexpr Field<LinuxParser::SchedCounters> vmstatFields[] = {
+  {"pgfault", &LinuxParser::SchedCounters::faults},
+  {"pgmajfault", &LinuxParser::SchedCounters::majorFaults}};
+constexpr FieldTable vmstatTable(vmstatFields);
+static_assert(vmstatTable.Perfect(), "vmstat keys collide, change the hash");
+
+/**
+ * @brief Read the system wide scheduling counters: run queue wait from
+ *        /proc/schedstat, context switches from /proc/stat and page
+ *        faults from /proc/vmstat
+ * 
+ * @param[out] counters Receives the counters
+ **/
+void LinuxParser::Scheduling(SchedCounters& counters)
+{
+  // built once, too long for the small string buffer
+  static const string schedstatPath = kProcDirectory + kSchedstatFilename;
+  static const string statPath      = kProcDirectory + kStatFilename;
+  static const string vmstatPath    = kProcDirectory + kVmstatFilename;
+
+  counters = SchedCounters();
+  string_view content = readFile(schedstatPath.c_str());
+  while (!content.empty())
+  {
+    const size_t end = std::min(content.find('\n'), content.size());
+    string_view line = content.substr(0, end);
+    content.remove_prefix(std::min(end + 1, content.size()));
+    if (line.compare(0, kFilterCpu.size(), kFilterCpu) != 0)
+    {
+      continue;
+    }
+
+    // "cpuN" and 9 numbers, the 8th is the time spent waiting in ns
+    line.remove_prefix(std::min(line.find(' '), line.size()));
+    long value = 0;
+    for (int field = 1; field <= 8 && !line.empty(); ++field)
+    {
+      line = parseNumber(line, value);
+    }
+    counters.waitNs = std::max(counters.waitNs, 0L) + value;
+  }
+
+  counters.contextSwitches = readValueFromFile<long>(statPath.c_str(), kFilterContextSwitches, 0);
+  vmstatTable.Extract(readFile(vmstatPath.c_str()), counters);
+}
+
+/**
+ * @brief Read the fields of /proc/meminfo in one scan
+ * 
+ * @param[out] memory Receives the values in kB
+ * @return false if the file could not be read
+ **/
+bool LinuxParser::Meminfo(MemInfo& memory)
+{
+  memory = MemInfo();
+  return meminfoTable.Extract(readFile((kProcDirectory + kMeminfoFilename).c_str()), memory) > 0;
 }
 
 /**
@@ -110,12 +310,11 @@ vector<int> LinuxParser::Pids() {
  **/
 float LinuxParser::MemoryUtilization()
 { 
-  const string filePath = kProcDirectory + kMeminfoFilename;
-  const int memTotal    = readValueFromFile<int>(filePath, kFilterMemTotal, 0);
-  const int memFree     = readValueFromFile<int>(filePath, kFilterMemFree, 0);
+  MemInfo memory;
+  Meminfo(memory);
   
   // return relative usage of memory
-  const float memUsed   = (memTotal == 0)? 0.0 : static_cast<float>(memTotal - memFree) / static_cast<float>(memTotal); 
+  const float memUsed   = (memory.total == 0)? 0.0 : static_cast<float>(memory.total - memory.free) / static_cast<float>(memory.total); 
   return memUsed; 
 }
 
@@ -126,14 +325,8 @@ float LinuxParser::MemoryUtilization()
  **/
 long LinuxParser::UpTime() 
 { 
-  long uptime = 0.0;
-
-  std::ifstream stream(kProcDirectory + kUptimeFilename);
-  if (stream.is_open()) 
-  {
-    stream >> uptime;
-  }
-  stream.close();
+  long uptime = 0;
+  parseNumber(readFile((kProcDirectory + kUptimeFilename).c_str()), uptime);
   return uptime; 
 }
 
@@ -158,30 +351,95 @@ long LinuxParser::Jiffies(const vector<long>& jiffies)
  **/ 
 long LinuxParser::ActiveJiffies(int pid) 
 { 
-  long uTime, sTime, cuTime, csTime;
+  ProcStat stat;
+  Stat(pid, stat);
+  return stat.activeJiffies;
+}
 
-  // define lambda function for skipping from reading determined number values 
-  const auto skip = [](std::ifstream& fs, int numberSkip)
-  {
-    string unused;
-    for (int k = 1; k <= numberSkip; k++)
-    {
-      fs >> unused;
-    } 
-  };
-  
-  std::ifstream fileStream(kProcDirectory + to_string(pid) + kStatFilename);
+/**
+ * @brief Read the values of /proc/<pid>/stat needed per tick in one pass
+ * 
+ * @param[in]  pid 
+ * @param[out] stat Receives active jiffies (#14-17) and start time (#22)
+ * 
+ * @return false if the process is gone
+ **/ 
+bool LinuxParser::Stat(int pid, ProcStat& stat) 
+{ 
+  char path[64];
+  return ParseStat(readFile(pidPath(path, sizeof(path), pid, kStatFilename)), stat);
+}
 
-  if (fileStream.is_open()) 
+/**
+ * @brief Parse the content of /proc/<pid>/stat, however it was read
+ * 
+ * @param[in]  content Content of the file
+ * @param[out] stat    Receives a hash of the command name (#2), 0 for
+ *                     kernel threads (#9), faults (#10, #12), active jiffies (#14-17), start time
+ *                     (#22), virtual size (#23) and resident pages (#24)
+ * 
+ * @return false if content is no stat line
+ **/ 
+bool LinuxParser::ParseStat(string_view content, ProcStat& stat) 
+{ 
+  // the command (#2) may contain blanks and parentheses, 
+  // everything behind the last ')' is separated by single blanks
+  const size_t commandEnd = content.rfind(')');
+  if (commandEnd == string_view::npos)
+  {
+    return false;
+  }
+  // FNV-1a, enough to notice an exec without keeping the name
+  stat.comm = 2166136261u;
+  for (size_t i = content.find('(') + 1; i < commandEnd; ++i)
   {
-    // skip reading of #1-13 values in file
-    skip(fileStream, 13);
-    // read #14-17
-    fileStream >> uTime >> sTime >> cuTime >> csTime;
+    stat.comm = (stat.comm ^ static_cast<unsigned char>(content[i])) * 16777619u;
   }
+  content.remove_prefix(commandEnd + 1);
 
-  long total_time = uTime + sTime + cuTime + csTime;  
-  return total_time;
+  long value = 0;
+  stat.activeJiffies = 0;
+  for (int field = 3; field <= 24 && !content.empty(); ++field)
+  {
+    content.remove_prefix(1);
+    if (field == 9)
+    {
+      // kernel threads (PF_KTHREAD) rename themselves, e.g. kworkers
+      // after their current work queue, but never exec
+      content = parseNumber(content, value);
+      stat.comm = (value & 0x00200000) != 0 ? 0 : stat.comm;
+    }
+    else if (field == 10)
+    {
+      content = parseNumber(content, stat.minorFaults);
+    }
+    else if (field == 12)
+    {
+      content = parseNumber(content, stat.majorFaults);
+    }
+    else if (field >= 14 && field <= 17)
+    {
+      content = parseNumber(content, value);
+      stat.activeJiffies += value;
+    }
+    else if (field == 22)
+    {
+      content = parseNumber(content, stat.startTime);
+    }
+    else if (field == 23)
+    {
+      content = parseNumber(content, stat.vsize);
+    }
+    else if (field == 24)
+    {
+      parseNumber(content, stat.rss);
+    }
+    else
+    {
+      content.remove_prefix(std::min(content.find(' '), content.size()));
+    }
+  }
+  return true;
 }
 
 /**
@@ -216,33 +474,83 @@ long LinuxParser::IdleJiffies(const vector<long>& jiffies)
  **/
 vector<long> LinuxParser::CpuUtilization() 
 { 
-  string key;
-  vector<long> values;
-
-  string line;
-
-  std::ifstream fileStream(kProcDirectory + kStatFilename);
-
-  if (fileStream.is_open()) {
-    while (std::getline(fileStream, line)) {
+  vector<vector<long>> cpus;
+  vector<int> ids;
+  CpuUtilizations(cpus, ids);
+  return cpus.empty() ? vector<long>() : cpus[0];  
+}
 
-      std::istringstream lineStream(line);
-      lineStream >> key; 
+/**
+ * @brief Read the aggregated and the per core CPU utilization in one pass
+ *        The vectors are reused, so nothing is allocated after the first call
+ *
+ * @param[out] cpus Jiffies of "cpu" at index 0, followed by the online
+ *                  cpus in the order of /proc/stat
+ * @param[out] ids  Id N of "cpuN" per entry of cpus, -1 for the aggregate;
+ *                  offline cpus are left out, so ids may have gaps
+ **/
+void LinuxParser::CpuUtilizations(vector<vector<long>>& cpus, vector<int>& ids)
+{
+  string_view content = readFile((kProcDirectory + kStatFilename).c_str());
+  size_t count = 0;
 
-      if (key == kFilterCpu)
+  // cpu lines come first
+  while (content.compare(0, kFilterCpu.size(), kFilterCpu) == 0)
+  {
+    const size_t end = std::min(content.find('\n'), content.size());
+    string_view line = content.substr(0, end);
+    content.remove_prefix(std::min(end + 1, content.size()));
+
+    // the key, "cpu" or "cpuN"
+    int id = -1;
+    line.remove_prefix(kFilterCpu.size());
+    if (!line.empty() && line[0] != ' ')
+    {
+      line = parseNumber(line, id);
+    }
+    line.remove_prefix(std::min(line.find(' '), line.size()));
+    if (count == cpus.size())
+    {
+      cpus.emplace_back();
+      ids.emplace_back();
+    }
+    ids[count] = id;
+    vector<long>& values = cpus[count++];
+    values.clear();
+    long value;
+    while (!line.empty())
+    {
+      const string_view rest = parseNumber(line, value);
+      if (rest.size() == line.size())
       {
-        std::copy(
-          std::istream_iterator<long>(lineStream), 
-          std::istream_iterator<long>(), 
-          std::back_inserter(values));
-        break;         
+        break;
       }
+      values.push_back(value);
+      line = rest;
     }
   }
-  fileStream.close();
-  return values;  
+  cpus.resize(count);
+  ids.resize(count);
+}
+
+/**
+ * @brief Read and return the load average of the last minute
+ *
+ * @return Load average
+ **/
+float LinuxParser::LoadAverage()
+{
+  float load = 0.0;
+  parseNumber(readFile((kProcDirectory + kLoadavgFilename).c_str()), load);
+  return load;
 }
 
+/**
+ * @brief Return the number of open/read/close calls the parsers issued
+ *        in the calling thread so far
+ **/
+std::uint64_t LinuxParser::Syscalls() { return syscalls; }
+
 /**
  * @brief Read and return the total number of processes
  * 
@@ -251,7 +559,7 @@ vector<long> LinuxParser::CpuUtilization()
 int LinuxParser::TotalProcesses() 
 { 
   const string filePath = kProcDirectory + kStatFilename;
-  const int totalNumber  = readValueFromFile<int>(filePath, kFilterProcesses, 0);
+  const int totalNumber  = readValueFromFile<int>(filePath.c_str(), kFilterProcesses, 0);
 
   return totalNumber; 
 }
@@ -265,27 +573,65 @@ int LinuxParser::RunningProcesses()
 { 
   const string filePath    = kProcDirectory + kStatFilename;
   
-  const int runningNumber  = readValueFromFile<int>(filePath, kFilterRunningProcesses, 0);
+  const int runningNumber  = readValueFromFile<int>(filePath.c_str(), kFilterRunningProcesses, 0);
 
   return runningNumber; 
 }
 
+/**
+ * @brief Read a small file with a single read() call
+ *
+ * @param[in]  filePath Full path to file
+ * @param[out] buffer   Receives the content, not null terminated
+ * @param[in]  size     Size of buffer
+ * @return number of bytes read, 0 on error
+ **/
+static size_t readOnce(const string& filePath, char* buffer, size_t size)
+{
+  const int fd = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+  ++syscalls;
+  if (fd < 0)
+  {
+    return 0;
+  }
+  const ssize_t length = read(fd, buffer, size);
+  close(fd);
+  syscalls += 2;
+  return (length > 0) ? static_cast<size_t>(length) : 0;
+}
+
 /**
  * @brief Read and return the command associated with a process
+ *        The whole argv is read at once, arguments are separated by spaces.
+ *        Command lines longer than 4 KiB are cut off.
+ *        Kernel threads have no argv, they get their name in brackets.
  *  
  * @param[in] pid  
- * @return command full path of associated process 
+ * @return command line of associated process 
  **/
 string LinuxParser::Command(int pid) 
 { 
-  string cmd;
+  char buffer[4096];
+  const string procPath = kProcDirectory + to_string(pid);
 
-  std::ifstream stream(kProcDirectory +  to_string(pid) + kCmdlineFilename);
-  if (stream.is_open()) {
-    stream >> cmd;
-  }  
-  stream.close();
-  return cmd; 
+  size_t length = readOnce(procPath + kCmdlineFilename, buffer, sizeof(buffer));
+  // argv is NUL separated and NUL terminated
+  while (length > 0 && buffer[length - 1] == '\0')
+  {
+    --length;
+  }
+  if (length > 0)
+  {
+    std::replace(buffer, buffer + length, '\0', ' ');
+    return string(buffer, length);
+  }
+
+  length = readOnce(procPath + kCommFilename, buffer, sizeof(buffer));
+  while (length > 0 && buffer[length - 1] == '\n')
+  {
+    --length;
+  }
+  return (length > 0) ? "[" + string(buffer, length) + "]" : string();
 }
 
 /**
@@ -296,10 +642,74 @@ string LinuxParser::Command(int pid)
  **/
 int LinuxParser::Ram(int pid) 
 { 
-  const string filePath = kProcDirectory +  to_string(pid) + kStatusFilename;
-  const int sizeInKB    = readValueFromFile<int>(filePath, kFilterProcMem, 0);
-  const int sizeInMB    = (int)( (sizeInKB / 1024.0) + 0.5);
-  return sizeInMB; 
+  ProcStatm statm;
+  Statm(pid, statm);
+  return statm.size;
+}
+
+/**
+ * @brief Read size and resident memory of a process
+ *
+ * @param[in]  pid   
+ * @param[out] statm Receives size and resident memory in mb
+ * @return false if the process is gone
+ **/
+bool LinuxParser::Statm(int pid, ProcStatm& statm) 
+{ 
+  char filePath[64];
+  return ParseStatm(readFile(pidPath(filePath, sizeof(filePath), pid, kStatmFilename)), statm);
+}
+
+/**
+ * @brief Parse the content of /proc/<pid>/statm, its first two fields are
+ *        the same as VmSize and VmRSS of /proc/<pid>/status but far
+ *        cheaper to read
+ *
+ * @param[in]  content Content of the file
+ * @param[out] statm   Receives size and resident memory in mb
+ * @return false if the content is empty
+ **/
+bool LinuxParser::ParseStatm(string_view content, ProcStatm& statm) 
+{ 
+  long pages    = 0;
+  long resident = 0;
+  parseNumber(parseNumber(content, pages), resident);
+  statm.size     = pagesToMB(pages);
+  statm.resident = pagesToMB(resident);
+  return !content.empty(); 
+}
+
+/**
+ * @brief Take size and resident memory from the same values of stat, so
+ *        a pass reading stat only does not need statm
+ *
+ * @param[in]  stat  Parsed /proc/<pid>/stat
+ * @param[out] statm Receives size and resident memory in mb
+ **/
+void LinuxParser::StatmOf(const ProcStat& stat, ProcStatm& statm) 
+{ 
+  static const long pageSize = sysconf(_SC_PAGESIZE);
+  statm.size     = pagesToMB(stat.vsize / pageSize);
+  statm.resident = pagesToMB(stat.rss);
+}
+
+/**
+ * @brief Read the scheduler statistics of a process
+ * 
+ * @param[in]  pid  
+ * @param[out] schedstat Receives time on cpu and waiting on a run queue
+ * @return false if the process is gone or the kernel lacks schedstats
+ **/
+bool LinuxParser::Schedstat(int pid, ProcSchedstat& schedstat) 
+{ 
+  char filePath[64];
+  string_view content = readFile(pidPath(filePath, sizeof(filePath), pid, kSchedstatFilename));
+  if (content.empty())
+  {
+    return false;
+  }
+  parseNumber(parseNumber(content, schedstat.runNs), schedstat.waitNs);
+  return true;
 }
 
 /**
@@ -310,9 +720,23 @@ int LinuxParser::Ram(int pid)
  **/
 int LinuxParser::Uid(int pid) 
 { 
-  const string filePath = kProcDirectory +  to_string(pid) + kStatusFilename;
-  const int uid      = readValueFromFile<int>(filePath, kFilterUID, 0);
-  return uid; 
+  ProcStatus status;
+  Status(pid, status);
+  return static_cast<int>(status.uid); 
+}
+
+/**
+ * @brief Read the fields of /proc/<pid>/status in one scan
+ * 
+ * @param[in]  pid  
+ * @param[out] status Receives the values, sizes in kB
+ * @return false if the process is gone
+ **/
+bool LinuxParser::Status(int pid, ProcStatus& status) 
+{ 
+  char filePath[64];
+  status = ProcStatus();
+  return statusTable.Extract(readFile(pidPath(filePath, sizeof(filePath), pid, kStatusFilename)), status) > 0;
 }
 
 /**
@@ -323,30 +747,41 @@ int LinuxParser::Uid(int pid)
  **/
 string LinuxParser::User(int pid) 
 { 
-  string user, passwd; 
-  int id;
+  return UserName(Uid(pid));
+}
+
+/**
+ * @brief Look up the name of a user in the password file
+ * 
+ * @param[in] uid User id 
+ * @return user name, empty if unknown
+ **/
+string LinuxParser::UserName(int uid) 
+{ 
+  PROFILE_SCOPE(Profiler::kUserLookup_);
   string line;
-  int uid = LinuxParser::Uid(pid);
   
   std::ifstream fileStream(kPasswordPath);
-  if (fileStream.is_open()) 
+  while (std::getline(fileStream, line))
   {
-    while (std::getline(fileStream, line))
+    // name:password:uid:..., the password may be empty
+    const size_t nameEnd = line.find(':');
+    const size_t uidBegin = (nameEnd == string::npos) ? string::npos : line.find(':', nameEnd + 1);
+    if (uidBegin == string::npos)
     {
-      std::replace(line.begin(), line.end(), ' ', '_');
-      std::replace(line.begin(), line.end(), ':', ' ');    
-
-      std::istringstream lineStream(line);
-      lineStream >> user >> passwd >> id;
-      if (uid == id)
-      {
-        break;
-      }
+      continue;
+    }
+    const size_t uidEnd = std::min(line.find(':', uidBegin + 1), line.size());
+    int id = -1;
+    const auto result = std::from_chars(line.data() + uidBegin + 1, line.data() + uidEnd, id);
+    if (result.ec == std::errc() && result.ptr == line.data() + uidEnd && id == uid)
+    {
+      string user = line.substr(0, nameEnd);
+      std::replace(user.begin(), user.end(), ' ', '_');
+      return user;
     }
   }
-
-  fileStream.close();
-  return user; 
+  return string(); 
 }
 
 /**
@@ -357,28 +792,137 @@ string LinuxParser::User(int pid)
  **/
 long LinuxParser::UpTime(int pid) 
 { 
-  int uptime;
+  ProcStat stat;
+  Stat(pid, stat);
+  return (stat.startTime / sysconf(_SC_CLK_TCK)); 
+}
 
-  // define lambda function for skipping from reading determined number values 
-  const auto skip = [](std::ifstream& fs, int numberSkip)
+/**
+ * @brief Read and return the ids of all NUMA nodes, sorted
+ * 
+ * @return node ids, empty without NUMA support
+ **/
+vector<int> LinuxParser::NumaNodes()
+{
+  vector<int> nodes;
+  DIR* directory = opendir(kNodeDirectory.c_str());
+  if (directory == nullptr)
+  {
+    return nodes;
+  }
+  while (const dirent* file = readdir(directory))
   {
-    string unused;
-    for (int k = 1; k <= numberSkip; k++)
+    // "node" followed by digits only
+    const string_view name(file->d_name);
+    int node = 0;
+    if (name.size() > 4 && name.compare(0, 4, "node") == 0 &&
+        parseNumber(name.substr(4), node).empty())
     {
-      fs >> unused;
-    } 
-  };
+      nodes.push_back(node);
+    }
+  }
+  closedir(directory);
+  std::sort(nodes.begin(), nodes.end());
+  return nodes;
+}
 
-  std::ifstream fileStream(kProcDirectory + to_string(pid) + kStatFilename);
+/**
+ * @brief Read and return the cpus of a NUMA node
+ * 
+ * @param[in] node Node id
+ * @return cpu ids, from a list like "0-3,8-11"
+ **/
+vector<int> LinuxParser::NodeCpus(int node)
+{
+  char filePath[96];
+  snprintf(filePath, sizeof(filePath), "%snode%d%s", kNodeDirectory.c_str(), node, kCpulistFilename.c_str());
+  string_view content = readFile(filePath);
 
-  if (fileStream.is_open()) 
+  vector<int> cpus;
+  while (!content.empty() && std::isdigit(content.front()))
   {
-    // skip reading of #1-#21 in file
-    skip(fileStream, 21);
-    // read #22 
-    fileStream >> uptime;
+    int first = 0;
+    content = parseNumber(content, first);
+    int last = first;
+    if (!content.empty() && content.front() == '-')
+    {
+      content = parseNumber(content.substr(1), last);
+    }
+    for (int cpu = first; cpu <= last; ++cpu)
+    {
+      cpus.push_back(cpu);
+    }
+    content.remove_prefix(!content.empty() && content.front() == ',');
   }
-  fileStream.close();
+  return cpus;
+}
+
+/**
+ * @brief Read the memory counters of a NUMA node in one scan
+ * 
+ * @param[in]  node   Node id
+ * @param[out] memory Receives total and free memory in kB, 
+ *                    MemAvailable is not reported per node
+ * @return false if the node is unknown
+ **/
+bool LinuxParser::NodeMeminfo(int node, MemInfo& memory)
+{
+  char filePath[96];
+  snprintf(filePath, sizeof(filePath), "%snode%d%s", kNodeDirectory.c_str(), node, kMeminfoFilename.c_str());
+  // every line starts with "Node <id> "
+  char prefix[32];
+  const int skip = snprintf(prefix, sizeof(prefix), "Node %d ", node);
+  memory = MemInfo();
+  return meminfoTable.Extract(readFile(filePath), memory, skip) > 0;
+}
 
-  return (uptime / sysconf(_SC_CLK_TCK)); 
+/**
+ * @brief Sum the pages of a process per NUMA node from its numa_maps,
+ *        lines carry tokens like "N0=12" and "kernelpagesize_kB=4"
+ * 
+ * @param[in]  pid    
+ * @param[out] nodeKb Resident kB per node id, grows to the highest node
+ * @return false if the process is gone or the kernel lacks numa_maps
+ **/
+bool LinuxParser::NumaMaps(int pid, vector<long>& nodeKb)
+{
+  static const string_view pageSizeKey("kernelpagesize_kB=");
+  char filePath[64];
+  string_view content = readFile(pidPath(filePath, sizeof(filePath), pid, kNumaMapsFilename));
+  std::fill(nodeKb.begin(), nodeKb.end(), 0);
+  if (content.empty())
+  {
+    return false;
+  }
+
+  while (!content.empty())
+  {
+    const size_t end = std::min(content.find('\n'), content.size());
+    string_view line = content.substr(0, end);
+    content.remove_prefix(std::min(end + 1, content.size()));
+
+    long pageKb = 4;
+    const size_t pageSize = line.find(pageSizeKey);
+    if (pageSize != string_view::npos)
+    {
+      parseNumber(line.substr(pageSize + pageSizeKey.size()), pageKb);
+    }
+    for (size_t token = line.find(" N"); token != string_view::npos; token = line.find(" N", token + 2))
+    {
+      int node  = 0;
+      long pages = 0;
+      string_view rest = parseNumber(line.substr(token + 2), node);
+      if (rest.empty() || rest.front() != '=' || node < 0)
+      {
+        continue;
+      }
+      parseNumber(rest.substr(1), pages);
+      if (static_cast<size_t>(node) >= nodeKb.size())
+      {
+        nodeKb.resize(node + 1, 0);
+      }
+      nodeKb[node] += pages * pageKb;
+    }
+  }
+  return true;
 }
@@ -1,7 +1,97 @@
+#include <cerrno>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "bench.h"
+#include "exporter.h"
 #include "ncurses_display.h"
+#include "rules.h"
+#include "snapshot.h"
 #include "system.h"
 
-int main() {
+int main(int argc, char* argv[]) {
+  bool selfStats{false};
+  bool uring{false};
+  bool numa{false};
+  std::string publish;
+  std::string attach;
+  std::string rulesFile;
+  std::string alerts;
+  std::string metrics;
+  std::size_t metricsTop{Exporter::kDefaultTop};
+  for (int i{1}; i < argc; ++i) {
+    const std::string option{argv[i]};
+    const bool hasValue{i + 1 < argc && argv[i + 1][0] != '-'};
+    // --self-stats: show p50/p99 of the monitor's own stages
+    if (option == "--self-stats") selfStats = true;
+    // --numa: show per node utilization and page placement
+    if (option == "--numa") numa = true;
+    // --uring: read per process files through io_uring if available
+    if (option == "--uring") uring = true;
+    // --bench [ticks]: headless benchmark of the collection path
+    if (option == "--bench")
+      return Bench::Run(hasValue ? std::atoi(argv[i + 1]) : 20);
+    // --publish [name]: headless collector, publishes to shared memory
+    if (option == "--publish")
+      publish = hasValue ? argv[++i] : Snapshot::kDefaultName;
+    // --attach [name]: display the snapshots of a running publisher
+    if (option == "--attach")
+      attach = hasValue ? argv[++i] : Snapshot::kDefaultName;
+    // --rules file: headless alerting on the rules of a config file
+    if (option == "--rules" && hasValue) rulesFile = argv[++i];
+    // --alerts file: append alert events to a file instead of stdout
+    if (option == "--alerts" && hasValue) alerts = argv[++i];
+    // --metrics [address]: headless OpenMetrics endpoint over HTTP
+    if (option == "--metrics")
+      metrics = hasValue ? argv[++i] : Exporter::kDefaultAddress;
+    // --metrics-top n: processes with per process series
+    if (option == "--metrics-top" && hasValue)
+      metricsTop = std::strtoul(argv[++i], nullptr, 10);
+  }
+
+  if (!publish.empty() + !rulesFile.empty() + !metrics.empty() > 1) {
+    std::cerr << "monitor: --publish, --rules and --metrics each run "
+                 "headless, attach them to one publisher with --attach\n";
+    return 1;
+  }
+
+  Rules rules;
+  if (!rulesFile.empty()) {
+    std::string error;
+    if (!rules.Load(rulesFile, error)) {
+      std::cerr << "monitor: " << error << "\n";
+      return 1;
+    }
+  }
+
+  if (!attach.empty()) {
+    SnapshotReader reader;
+    if (!reader.Open(attach)) {
+      std::cerr << "monitor: cannot attach to " << attach << ": "
+                << std::strerror(errno) << "\n";
+      return 1;
+    }
+    System system(&reader);
+    if (!rulesFile.empty() && rules.Rates()) {
+      // the publisher samples rates for its top processes only
+      std::cerr << "monitor: rules on wait, switches or faults need their "
+                   "own collection, run --rules without --attach\n";
+      return 1;
+    }
+    if (!rulesFile.empty()) return Rules::Serve(system, rules, alerts);
+    if (!metrics.empty()) return Exporter::Serve(system, metrics, metricsTop);
+    NCursesDisplay::Display(system, selfStats, numa);
+    return 0;
+  }
+
   System system;
-  NCursesDisplay::Display(system);
-}
\ No newline at end of file
+  // falls back to plain reads silently
+  if (uring) system.Table().Reader().UseUring();
+  if (!publish.empty()) return Snapshot::Serve(system, publish);
+  if (!rulesFile.empty()) return Rules::Serve(system, rules, alerts);
+  if (!metrics.empty()) return Exporter::Serve(system, metrics, metricsTop);
+  NCursesDisplay::Display(system, selfStats, numa);
+}
@@ -1,16 +1,25 @@
 #include <curses.h>
+#include <algorithm>
 #include <chrono>
+#include <cstdlib>
 #include <string>
-#include <thread>
 #include <vector>
 
 #include "format.h"
 #include "ncurses_display.h"
+#include "profiler.h"
 #include "system.h"
 
 using std::string;
 using std::to_string;
 
+namespace {
+// rows of the system window besides the history of single cores
+int const kSystemRows{14};
+// at most this many cores get a history row
+int const kCoreRows{8};
+}  // namespace
+
 // 50 bars uniformly displayed from 0 - 100 %
 // 2% is one bar(|)
 std::string NCursesDisplay::ProgressBar(float percent) {
@@ -28,20 +37,107 @@ std::string NCursesDisplay::ProgressBar(float percent) {
   return result + " " + display + "/100%";
 }
 
+// One character per value, the levels go from ' ' (0) up to '@' (scale).
+// With scale 0 the largest value of the series is the top level.
+std::string NCursesDisplay::Sparkline(const std::vector<float>& values,
+                                      int width, float scale) {
+  static const std::string levels{" .:-=+*#&@"};
+  const int top = levels.size() - 1;
+  if (scale <= 0) {
+    for (float value : values) scale = std::max(scale, value);
+  }
+  std::string result(std::max(0, width - int(values.size())), ' ');
+  const int first = std::max(0, int(values.size()) - width);
+  for (int i{first}; i < int(values.size()); ++i) {
+    int level = scale > 0 ? int(values[i] / scale * top + 0.5) : 0;
+    result += levels[std::min(std::max(level, 0), top)];
+  }
+  return result;
+}
+
+// min/avg/max of the last 10 minutes (finest resolution)
+std::string NCursesDisplay::Summary(const TimeSeries& series, float scale,
+                                    const std::string& unit) {
+  const TimeSeries::Summary summary = series.Summarize(series.Size());
+  return "min " + to_string(summary.min * scale).substr(0, 4) + " avg " +
+         to_string(summary.avg * scale).substr(0, 4) + " max " +
+         to_string(summary.max * scale).substr(0, 4) + unit;
+}
+
 void NCursesDisplay::DisplaySystem(System& system, WINDOW* window) {
+  PROFILE_SCOPE(Profiler::kDisplaySystem_);
   int row{0};
+  int const spark_width{50};
+  std::vector<float> values;
+  const MetricHistory& history = system.History();
   mvwprintw(window, ++row, 2, ("OS: " + system.OperatingSystem()).c_str());
   mvwprintw(window, ++row, 2, ("Kernel: " + system.Kernel()).c_str());
   mvwprintw(window, ++row, 2, "CPU: ");
   wattron(window, COLOR_PAIR(1));
   mvwprintw(window, row, 10, "");
-  wprintw(window, ProgressBar(system.Cpu().Utilization()).c_str());
+  wprintw(window, ProgressBar(system.CpuUtilization()).c_str());
   wattroff(window, COLOR_PAIR(1));
+  history.Cpu().Recent(spark_width, values);
+  mvwprintw(window, ++row, 12,
+            (Sparkline(values, spark_width, 1) + "  " +
+             Summary(history.Cpu(), 100, "%%"))
+                .c_str());
+  std::vector<float> cores;
+  for (float core : system.CoreUtilizations()) cores.push_back(core);
+  mvwprintw(window, ++row, 2, "Cores: ");
+  mvwprintw(window, row, 12,
+            Sparkline(cores, std::min(int(cores.size()), getmaxx(window) - 14), 1)
+                .c_str());
+  // history per core in the rows the window has for them, the busiest
+  // cores of the sparkline period if there are more cores than rows
+  const std::vector<TimeSeries>& core_history = history.Cores();
+  std::vector<int> shown(core_history.size());
+  for (size_t i{0}; i < shown.size(); ++i) shown[i] = int(i);
+  int const core_rows{std::max(0, getmaxy(window) - kSystemRows)};
+  if (int(shown.size()) > core_rows) {
+    std::partial_sort(shown.begin(), shown.begin() + core_rows, shown.end(),
+                      [&](int a, int b) {
+                        return core_history[b].Summarize(spark_width).avg <
+                               core_history[a].Summarize(spark_width).avg;
+                      });
+    shown.resize(core_rows);
+    std::sort(shown.begin(), shown.end());
+  }
+  for (int core : shown) {
+    core_history[core].Recent(spark_width, values);
+    mvwprintw(window, ++row, 4, "%s", ("cpu" + to_string(core)).c_str());
+    mvwprintw(window, row, 12,
+              (Sparkline(values, spark_width, 1) + "  " +
+               Summary(core_history[core], 100, "%%"))
+                  .c_str());
+  }
   mvwprintw(window, ++row, 2, "Memory: ");
   wattron(window, COLOR_PAIR(1));
   mvwprintw(window, row, 10, "");
   wprintw(window, ProgressBar(system.MemoryUtilization()).c_str());
   wattroff(window, COLOR_PAIR(1));
+  history.Memory().Recent(spark_width, values);
+  mvwprintw(window, ++row, 12,
+            (Sparkline(values, spark_width, 1) + "  " +
+             Summary(history.Memory(), 100, "%%"))
+                .c_str());
+  history.Load().Recent(spark_width, values);
+  mvwprintw(window, ++row, 2,
+            ("Load: " + to_string(system.LoadAverage()).substr(0, 4)).c_str());
+  mvwprintw(window, row, 12,
+            (Sparkline(values, spark_width) + "  " +
+             Summary(history.Load(), 1, ""))
+                .c_str());
+  // rates since the previous tick
+  const std::string wait = system.WaitRate() < 0
+                               ? std::string("n/a")
+                               : Format::Rate(system.WaitRate()) + "ms/s";
+  mvwprintw(window, ++row, 2, "%s",
+            ("Sched: wait " + wait + "  ctxt " +
+             Format::Rate(system.SwitchRate()) + "/s  faults " +
+             Format::Rate(system.MinorFaultRate()) + "/s  major " +
+             Format::Rate(system.MajorFaultRate()) + "/s")
+                .c_str());
   mvwprintw(window, ++row, 2,
             ("Total Processes: " + to_string(system.TotalProcesses())).c_str());
   mvwprintw(
@@ -53,63 +149,410 @@ void NCursesDisplay::DisplaySystem(System& system, WINDOW* window) {
 }
 
 void NCursesDisplay::DisplayProcesses(std::vector<Process>& processes,
+                                      const std::vector<int>& rows, int first,
+                                      int cursor, ProcessTable::SortKey sort,
+                                      const MetricHistory& history,
                                       WINDOW* window, int n) {
+  PROFILE_SCOPE(Profiler::kDisplayProcesses_);
   int row{0};
   int const pid_column{1};
   int const user_column{9};
   int const cpu_column{20};
   int const ram_column{30};
   int const time_column{39};
-  int const command_column{50};
+  int const history_column{50};
+  int const history_width{10};
+  int const wait_column{62};
+  int const switches_column{71};
+  int const faults_column{83};
+  // the rate columns are dropped if they leave no room for the command
+  bool const rates{getmaxx(window) >= 95 + 20};
+  int const command_column{rates ? 95 : wait_column};
+  std::vector<float> values;
+  // the sorted column is marked with '*'
+  const auto header = [&](ProcessTable::SortKey key, const char* title) {
+    return std::string(title) + (key == sort ? "*" : "");
+  };
+  werase(window);
+  box(window, 0, 0);
   wattron(window, COLOR_PAIR(2));
-  mvwprintw(window, ++row, pid_column + 2, "PID");
-  mvwprintw(window, row, user_column, "USER");
+  mvwprintw(window, ++row, pid_column + 2, "%s",
+            header(ProcessTable::kSortPid_, "PID").c_str());
+  mvwprintw(window, row, user_column, "%s",
+            header(ProcessTable::kSortUser_, "USER").c_str());
+  mvwprintw(window, row, cpu_column, "%s",
+            header(ProcessTable::kSortCpu_, "CPU[%]").c_str());
+  mvwprintw(window, row, ram_column, "%s",
+            header(ProcessTable::kSortRam_, "RAM[MB]").c_str());
+  mvwprintw(window, row, time_column, "%s",
+            header(ProcessTable::kSortTime_, "TIME+").c_str());
+  mvwprintw(window, row, history_column, "CPU HIST");
+  if (rates) {
+    mvwprintw(window, row, wait_column, "%s",
+              header(ProcessTable::kSortWait_, "WAIT[ms]").c_str());
+    mvwprintw(window, row, switches_column, "%s",
+              header(ProcessTable::kSortSwitches_, "CSW vol/inv").c_str());
+    mvwprintw(window, row, faults_column, "%s",
+              header(ProcessTable::kSortFaults_, "FLT min/maj").c_str());
+  }
+  mvwprintw(window, row, command_column, "%s",
+            header(ProcessTable::kSortCommand_, "COMMAND").c_str());
+  wattroff(window, COLOR_PAIR(2));
+  int const last = std::min(int(rows.size()), first + n);
+
+  for (int i = first; i < last; ++i) {
+    const Process& process = processes[rows[i]];
+    if (i == cursor) wattron(window, A_REVERSE);
+    mvwprintw(window, ++row, pid_column, "%s", Format::Pid(process.Pid()).c_str());
+    mvwprintw(window, row, user_column, "%s", process.User().c_str());
+    
+    float cpu = process.CpuUtilization() * 100;
+    mvwprintw(window, row, cpu_column, "%s", to_string(cpu).substr(0, 4).c_str());
+
+    mvwprintw(window, row, ram_column, "%s", Format::Ram(process.Ram()).c_str());
+    mvwprintw(window, row, time_column, "%s",
+              Format::ElapsedTime(process.UpTime()).c_str());
+    const TimeSeries* cpuHistory = history.ProcessCpu(process.Pid());
+    values.clear();
+    if (cpuHistory != nullptr) cpuHistory->Recent(history_width, values);
+    mvwprintw(window, row, history_column, "%s",
+              Sparkline(values, history_width, 1).c_str());
+    // per second, only sampled for visible and top processes
+    if (rates) {
+      mvwprintw(window, row, wait_column, "%s",
+                Format::Rate(process.WaitRate()).c_str());
+      mvwprintw(window, row, switches_column, "%s",
+                (Format::Rate(process.VoluntarySwitchRate()) + "/" +
+                 Format::Rate(process.InvoluntarySwitchRate()))
+                    .c_str());
+      mvwprintw(window, row, faults_column, "%s",
+                (Format::Rate(process.MinorFaultRate()) + "/" +
+                 Format::Rate(process.MajorFaultRate()))
+                    .c_str());
+    }
+    mvwprintw(window, row, command_column, "%s",
+              Format::Command(process.Command(), window->_maxx - command_column).c_str());
+    if (i == cursor) wattroff(window, A_REVERSE);
+  }
+  wrefresh(window);
+}
+
+// One line with the active sort/filters, the key help or a message
+void NCursesDisplay::DisplayStatus(const ProcessTable::View& view,
+                                   std::size_t shown, std::size_t total,
+                                   const std::string& message,
+                                   WINDOW* window) {
+  PROFILE_SCOPE(Profiler::kDisplayStatus_);
+  static const char* const sortNames[] = {"cpu",     "ram",  "pid",
+                                          "user",    "time", "command",
+                                          "wait",    "switches", "faults"};
+  std::string status = std::string(" sort: ") + sortNames[view.sort] +
+                       (view.reverse ? " (reversed)" : "");
+  if (!view.user.empty()) status += " | user: " + view.user;
+  if (!view.command.empty())
+    status += view.regex ? " | regex: " + view.command
+                         : " | command: " + view.command;
+  status += " | " + to_string(shown) + "/" + to_string(total) + " | ";
+  status += message.empty() ? "c/m/p/u/t/n/w/s/v sort, r reverse, / \\ f filter, "
+                              "g pid, x clear, q quit"
+                            : message;
+  werase(window);
+  wattron(window, A_REVERSE);
+  mvwprintw(window, 0, 0, "%-*s", getmaxx(window),
+            status.substr(0, getmaxx(window)).c_str());
+  wattroff(window, A_REVERSE);
+  wrefresh(window);
+}
+
+// Per node cpu and memory, then the page placement of the top processes,
+// shown with --numa
+void NCursesDisplay::DisplayNuma(const Numa& numa,
+                                 const std::vector<Process>& processes,
+                                 WINDOW* window) {
+  PROFILE_SCOPE(Profiler::kDisplayNuma_);
+  int row{0};
+  int const cpus_column{10};
+  int const cpu_column{18};
+  int const memory_column{26};
+  int const node_width{9};
+  werase(window);
+  box(window, 0, 0);
+  if (!numa.Available()) {
+    mvwprintw(window, ++row, 2, "NUMA: no nodes, none reported or attached to a publisher");
+    wrefresh(window);
+    return;
+  }
+  wattron(window, COLOR_PAIR(2));
+  mvwprintw(window, ++row, 2, "NODE");
+  mvwprintw(window, row, cpus_column, "CPUS");
   mvwprintw(window, row, cpu_column, "CPU[%%]");
-  mvwprintw(window, row, ram_column, "RAM[MB]");
-  mvwprintw(window, row, time_column, "TIME+");
-  mvwprintw(window, row, command_column, "COMMAND");
+  mvwprintw(window, row, memory_column, "MEM USED/TOTAL[MB]");
   wattroff(window, COLOR_PAIR(2));
-  int const num_processes = int(processes.size()) > n ? n : processes.size();
+  for (const Numa::Node& node : numa.Nodes()) {
+    mvwprintw(window, ++row, 2, "node%d", node.id);
+    mvwprintw(window, row, cpus_column, "%d", int(node.cpus.size()));
+    mvwprintw(window, row, cpu_column, "%s",
+              to_string(node.cpuUtilization * 100).substr(0, 4).c_str());
+    mvwprintw(window, row, memory_column, "%ld/%ld",
+              (node.memTotal - node.memFree) / 1024, node.memTotal / 1024);
+  }
 
-  for (int i = 0; i < num_processes; ++i) {
+  // resident MB per node of the top processes
+  wattron(window, COLOR_PAIR(2));
+  mvwprintw(window, ++row, 2, "PID");
+  for (size_t n{0}; n < numa.Nodes().size(); ++n)
+    mvwprintw(window, row, cpus_column + int(n) * node_width, "node%d[MB]",
+              numa.Nodes()[n].id);
+  wattroff(window, COLOR_PAIR(2));
+  for (const Numa::ProcessPages& pages : numa.Processes()) {
+    mvwprintw(window, ++row, 2, "%d", pages.pid);
+    for (size_t n{0}; n < pages.kb.size(); ++n)
+      mvwprintw(window, row, cpus_column + int(n) * node_width, "%ld",
+                pages.kb[n] / 1024);
+    // the command helps to tell the top processes apart, if it fits
+    int const command_column{cpus_column + int(pages.kb.size()) * node_width};
+    int const command_width{getmaxx(window) - 2 - command_column};
+    if (command_width <= 1) continue;
+    const auto process =
+        std::find_if(processes.begin(), processes.end(),
+                     [&](const Process& p) { return p.Pid() == pages.pid; });
+    if (process != processes.end())
+      mvwprintw(window, row, command_column, "%s",
+                Format::Command(process->Command(), command_width).c_str());
+  }
+  wrefresh(window);
+}
 
-    mvwprintw(window, ++row, pid_column, Format::Pid(processes[i].Pid()).c_str());
-    mvwprintw(window, row, user_column, processes[i].User().c_str());
-    
-    float cpu = processes[i].CpuUtilization() * 100;
-    mvwprintw(window, row, cpu_column, to_string(cpu).substr(0, 4).c_str());
-
-    mvwprintw(window, row, ram_column, Format::Ram(processes[i].Ram()).c_str());
-    mvwprintw(window, row, time_column,
-              Format::ElapsedTime(processes[i].UpTime()).c_str());
-    mvwprintw(window, row, command_column,
-              Format::Command(processes[i].Command(), window->_maxx - command_column).c_str());
+// p50/p99 of the monitor's own stages, shown with --self-stats
+void NCursesDisplay::DisplaySelfStats(WINDOW* window) {
+  PROFILE_SCOPE(Profiler::kDisplaySelfStats_);
+  int row{0};
+  const std::vector<std::string> lines = Profiler::Report();
+  for (size_t i{0}; i < lines.size(); ++i) {
+    wattron(window, COLOR_PAIR(i == 0 ? 2 : 0));
+    mvwprintw(window, ++row, 2, lines[i].c_str());
+    wattroff(window, COLOR_PAIR(i == 0 ? 2 : 0));
   }
   wrefresh(window);
 }
 
-void NCursesDisplay::Display(System& system, int n) {
+namespace {
+// Read a line of text, typed into the status line
+std::string prompt(WINDOW* window, const std::string& label) {
+  char input[256]{};
+  werase(window);
+  mvwprintw(window, 0, 0, "%s", label.c_str());
+  wrefresh(window);
+  echo();
+  curs_set(1);
+  wtimeout(window, -1);
+  wgetnstr(window, input, sizeof(input) - 1);
+  curs_set(0);
+  noecho();
+  return input;
+}
+
+// Scroll state of the process list, the cursor follows its pid across ticks
+struct Navigation {
+  int cursor{0};
+  int first{0};
+  int pid{-1};
+};
+
+// Put the cursor back on its pid after a new selection and keep it visible
+void follow(Navigation& navigation, const std::vector<Process>& processes,
+            const std::vector<int>& rows, int visible) {
+  if (navigation.pid != -1) {
+    for (int i{0}; i < int(rows.size()); ++i) {
+      if (processes[rows[i]].Pid() == navigation.pid) {
+        navigation.cursor = i;
+        break;
+      }
+    }
+  }
+  navigation.cursor =
+      std::max(0, std::min(navigation.cursor, int(rows.size()) - 1));
+  if (navigation.cursor < navigation.first) navigation.first = navigation.cursor;
+  if (navigation.cursor >= navigation.first + visible)
+    navigation.first = navigation.cursor - visible + 1;
+  navigation.first = std::max(
+      0, std::min(navigation.first, int(rows.size()) - visible));
+  navigation.pid =
+      rows.empty() ? -1 : processes[rows[navigation.cursor]].Pid();
+}
+}  // namespace
+
+void NCursesDisplay::Display(System& system, bool selfStats, bool numa) {
   initscr();      // start ncurses
   noecho();       // do not print input values
   cbreak();       // terminate ncurses on ctrl + c
   start_color();  // enable color
+  keypad(stdscr, TRUE);  // arrow and page keys
+  curs_set(0);
 
   int x_max{getmaxx(stdscr)};
-  WINDOW* system_window = newwin(9, x_max - 1, 0, 0);
-  WINDOW* process_window =
-      newwin(3 + n, x_max - 1, system_window->_maxy + 1, 0);
-
-  while (1) {
-    init_pair(1, COLOR_BLUE, COLOR_BLACK);
-    init_pair(2, COLOR_GREEN, COLOR_BLACK);
-    box(system_window, 0, 0);
-    box(process_window, 0, 0);
-    DisplaySystem(system, system_window);
-    DisplayProcesses(system.Processes(), process_window, n);
-    wrefresh(system_window);
-    wrefresh(process_window);
-    refresh();
-    std::this_thread::sleep_for(std::chrono::seconds(1));
+  int const stats_height =
+      selfStats ? 3 + Profiler::kStageCount_ + Profiler::kCounterCount_ : 0;
+  // nodes, then numa_maps of the top processes
+  int const numa_processes{5};
+  if (numa) system.EnableNuma(numa_processes);
+  int const numa_height =
+      numa ? 4 + std::max<int>(1, system.NumaNodes().Nodes().size()) +
+                 numa_processes
+           : 0;
+  // the first frame comes from a cheap pass, the second tick completes
+  // it; it runs before the layout, which depends on the number of cores
+  system.Update(true);
+  int const core_rows{
+      std::min(int(system.CoreUtilizations().size()), kCoreRows)};
+  WINDOW* system_window = newwin(kSystemRows + core_rows, x_max - 1, 0, 0);
+  WINDOW* stats_window =
+      selfStats
+          ? newwin(stats_height, x_max - 1, system_window->_maxy + 1, 0)
+          : nullptr;
+  WINDOW* numa_window =
+      numa ? newwin(numa_height, x_max - 1,
+                    system_window->_maxy + 1 + stats_height, 0)
+           : nullptr;
+  int const top_height = system_window->_maxy + 1 + stats_height + numa_height;
+  // the process list gets the rest of the screen, at least one row; on a
+  // short screen it covers the bottom of the windows above instead of
+  // pushing itself and the status line off the screen
+  int const visible = std::max(1, getmaxy(stdscr) - top_height - 4);
+  WINDOW* process_window = newwin(
+      3 + visible, x_max - 1,
+      std::max(0, std::min(top_height, getmaxy(stdscr) - 4 - visible)), 0);
+  WINDOW* status_window =
+      newwin(1, x_max - 1,
+             std::min(getbegy(process_window) + getmaxy(process_window),
+                      getmaxy(stdscr) - 1),
+             0);
+
+  ProcessTable& table = system.Table();
+  ProcessTable::View view;
+  Navigation navigation;
+  std::vector<int> rows;
+  std::vector<int> watched;
+  std::string message;
+  auto next = std::chrono::steady_clock::now();
+  bool first{true};
+  bool quit{false};
+
+  init_pair(1, COLOR_BLUE, COLOR_BLACK);
+  init_pair(2, COLOR_GREEN, COLOR_BLACK);
+  while (!quit) {
+    auto now = std::chrono::steady_clock::now();
+    if (now >= next) {
+      // collect once per second, key presses only render again
+      if (!first) system.Update();
+      first = false;
+      box(system_window, 0, 0);
+      DisplaySystem(system, system_window);
+      if (stats_window != nullptr) {
+        box(stats_window, 0, 0);
+        DisplaySelfStats(stats_window);
+      }
+      if (numa_window != nullptr)
+        DisplayNuma(system.NumaNodes(), system.Processes(), numa_window);
+      next = now + std::chrono::seconds(1);
+    }
+    if (!table.Select(view, rows)) message = "invalid regex, filter ignored";
+    follow(navigation, system.Processes(), rows, visible);
+    // the next ticks sample scheduler and fault rates of the visible rows
+    watched.clear();
+    for (int i{navigation.first};
+         i < std::min(int(rows.size()), navigation.first + visible); ++i)
+      watched.push_back(system.Processes()[rows[i]].Pid());
+    system.Watch(watched);
+    table.Resolve(watched);
+    DisplayProcesses(system.Processes(), rows, navigation.first,
+                     navigation.cursor, view.sort, system.History(),
+                     process_window, visible);
+    DisplayStatus(view, rows.size(), table.Size(), message, status_window);
+    message.clear();
+
+    const auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+        next - std::chrono::steady_clock::now());
+    timeout(std::max<int>(0, wait.count()));
+    int const key = getch();
+    switch (key) {
+      case ERR:
+        break;
+      case 'q':
+        quit = true;
+        break;
+      case 'c': view.sort = ProcessTable::kSortCpu_; break;
+      case 'm': view.sort = ProcessTable::kSortRam_; break;
+      case 'p': view.sort = ProcessTable::kSortPid_; break;
+      case 'u': view.sort = ProcessTable::kSortUser_; break;
+      case 't': view.sort = ProcessTable::kSortTime_; break;
+      case 'n': view.sort = ProcessTable::kSortCommand_; break;
+      case 'w': view.sort = ProcessTable::kSortWait_; break;
+      case 's': view.sort = ProcessTable::kSortSwitches_; break;
+      case 'v': view.sort = ProcessTable::kSortFaults_; break;
+      case 'r': view.reverse = !view.reverse; break;
+      case '/':
+        view.command = prompt(status_window, "command contains: ");
+        view.regex = false;
+        break;
+      case '\\':
+        view.command = prompt(status_window, "command regex: ");
+        view.regex = true;
+        break;
+      case 'f':
+        view.user = prompt(status_window, "user contains: ");
+        break;
+      case 'x':
+        view.user.clear();
+        view.command.clear();
+        break;
+      case 'g': {
+        // pid index lookup, the filters are dropped if they hide the pid
+        const std::string input = prompt(status_window, "pid: ");
+        const int pid = std::atoi(input.c_str());
+        if (table.Find(pid) == nullptr) {
+          message = "pid " + input + " not found";
+        } else {
+          navigation.pid = pid;
+          if (table.Select(view, rows) &&
+              std::none_of(rows.begin(), rows.end(), [&](int row) {
+                return system.Processes()[row].Pid() == pid;
+              })) {
+            view.user.clear();
+            view.command.clear();
+          }
+        }
+        break;
+      }
+      case KEY_UP:
+      case 'k':
+        navigation.pid = -1;
+        --navigation.cursor;
+        break;
+      case KEY_DOWN:
+      case 'j':
+        navigation.pid = -1;
+        ++navigation.cursor;
+        break;
+      case KEY_PPAGE:
+        navigation.pid = -1;
+        navigation.cursor -= visible;
+        break;
+      case KEY_NPAGE:
+        navigation.pid = -1;
+        navigation.cursor += visible;
+        break;
+      case KEY_HOME:
+        navigation.pid = -1;
+        navigation.cursor = 0;
+        break;
+      case KEY_END:
+        navigation.pid = -1;
+        navigation.cursor = int(rows.size()) - 1;
+        break;
+      default:
+        break;
+    }
   }
   endwin();
 }
@@ -0,0 +1,97 @@
+#include <algorithm>
+#include <cstddef>
+#include <vector>
+
+#include "linux_parser.h"
+#include "numa.h"
+#include "process.h"
+
+using std::size_t;
+using std::vector;
+
+/**
+ * @brief Discover the nodes and their cpus
+ **/
+void Numa::Discover()
+{
+    _nodes.clear();
+    for (const int id : LinuxParser::NumaNodes())
+    {
+        Node node;
+        node.id   = id;
+        node.cpus = LinuxParser::NodeCpus(id);
+        _nodes.push_back(std::move(node));
+    }
+}
+
+/**
+ * @brief Return if the kernel reports any NUMA node
+ **/
+bool Numa::Available() const { return !_nodes.empty(); }
+
+/**
+ * @brief Return all nodes, sorted by id
+ **/
+const vector<Numa::Node>& Numa::Nodes() const { return _nodes; }
+
+/**
+ * @brief Refresh cpu and memory utilization of every node
+ *
+ * @param[in] coreUtilizations Utilization by cpu id, see System::CoreUtilizations
+ **/
+void Numa::Update(const vector<float>& coreUtilizations)
+{
+    for (auto& node : _nodes)
+    {
+        float sum   = 0;
+        int counted = 0;
+        for (const int cpu : node.cpus)
+        {
+            if (cpu >= 0 && static_cast<size_t>(cpu) < coreUtilizations.size())
+            {
+                sum += coreUtilizations[cpu];
+                ++counted;
+            }
+        }
+        node.cpuUtilization = (counted > 0) ? sum / counted : 0;
+
+        LinuxParser::MemInfo memory;
+        LinuxParser::NodeMeminfo(node.id, memory);
+        node.memTotal = memory.total;
+        node.memFree  = memory.free;
+    }
+}
+
+/**
+ * @brief Sample the page placement of some processes
+ *
+ * @param[in] processes All processes
+ * @param[in] rows      Rows into processes, e.g. the top processes
+ * @param[in] count     Max number of rows to sample
+ **/
+void Numa::UpdateProcesses(const vector<Process>& processes,
+                           const vector<int>& rows, size_t count)
+{
+    count = std::min(count, rows.size());
+    _processes.resize(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        ProcessPages& pages = _processes[i];
+        pages.pid = processes[rows[i]].Pid();
+        pages.kb.assign(_nodes.size(), 0);
+        if (!LinuxParser::NumaMaps(pages.pid, _nodeKb))
+        {
+            continue;
+        }
+        for (size_t n = 0; n < _nodes.size(); ++n)
+        {
+            const int id = _nodes[n].id;
+            pages.kb[n] = (static_cast<size_t>(id) < _nodeKb.size()) ? _nodeKb[id] : 0;
+        }
+    }
+}
+
+/**
+ * @brief Return the page placement of the sampled processes
+ **/
+const vector<Numa::ProcessPages>& Numa::Processes() const { return _processes; }
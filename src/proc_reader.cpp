@@ -0,0 +1,405 @@
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+#include "linux_parser.h"
+#include "proc_reader.h"
+
+using std::size_t;
+using std::string_view;
+using std::vector;
+
+namespace {
+// files read per pid, in slot order
+enum File { kStat_ = 0, kStatm_, kFileCount_ };
+
+constexpr size_t kBatchPids   = 256;
+constexpr size_t kBatchFiles  = kBatchPids * kFileCount_;
+// a read and a close per file
+constexpr unsigned kEntries   = 2 * kBatchFiles;
+// larger than any stat line, a full buffer is read again synchronously
+constexpr size_t kBufferSize  = 1024;
+constexpr size_t kPathSize    = 32;
+}  // namespace
+
+// Mappings of an io_uring instance and the buffers of one batch
+struct ProcReader::Ring {
+  int fd{-1};
+  void* sqRing{MAP_FAILED};
+  size_t sqRingSize{0};
+  void* cqRing{MAP_FAILED};
+  size_t cqRingSize{0};
+  io_uring_sqe* sqes{static_cast<io_uring_sqe*>(MAP_FAILED)};
+  size_t sqesSize{0};
+  unsigned* sqTail{nullptr};
+  unsigned* sqMask{nullptr};
+  unsigned* sqArray{nullptr};
+  unsigned* cqHead{nullptr};
+  unsigned* cqTail{nullptr};
+  unsigned* cqMask{nullptr};
+  io_uring_cqe* cqes{nullptr};
+  unsigned tail{0};     // local submission tail, published by submit
+  unsigned queued{0};   // entries not yet submitted
+
+  // per file slot of the current batch
+  char paths[kBatchFiles][kPathSize];
+  int fds[kBatchFiles];
+  int lengths[kBatchFiles];
+  vector<char> buffers = vector<char>(kBatchFiles * kBufferSize);
+
+  ~Ring();
+  bool Setup();
+  io_uring_sqe& Next();
+  template <typename Handle>
+  bool Submit(unsigned expected, std::uint64_t& syscalls, Handle handle);
+};
+
+ProcReader::Ring::~Ring()
+{
+    if (sqes != MAP_FAILED)
+    {
+        munmap(sqes, sqesSize);
+    }
+    if (cqRing != MAP_FAILED && cqRing != sqRing)
+    {
+        munmap(cqRing, cqRingSize);
+    }
+    if (sqRing != MAP_FAILED)
+    {
+        munmap(sqRing, sqRingSize);
+    }
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+}
+
+/**
+ * @brief Create the io_uring instance and map its rings
+ *
+ * @return false if io_uring is not available
+ **/
+bool ProcReader::Ring::Setup()
+{
+    io_uring_params params;
+    std::memset(&params, 0, sizeof(params));
+    fd = static_cast<int>(syscall(__NR_io_uring_setup, kEntries, &params));
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool single = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (single)
+    {
+        sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+    }
+    sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+    if (sqRing == MAP_FAILED)
+    {
+        return false;
+    }
+    cqRing = single ? sqRing
+                    : mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE,
+                           MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+    if (cqRing == MAP_FAILED)
+    {
+        return false;
+    }
+    sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    sqes = static_cast<io_uring_sqe*>(mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE,
+                                           MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+    if (sqes == MAP_FAILED)
+    {
+        return false;
+    }
+
+    char* sq = static_cast<char*>(sqRing);
+    char* cq = static_cast<char*>(cqRing);
+    sqTail  = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+    sqMask  = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+    sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+    cqHead  = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+    cqTail  = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+    cqMask  = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+    cqes    = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+    tail    = *sqTail;
+    return true;
+}
+
+/**
+ * @brief Return a cleared submission entry, queued until Submit
+ **/
+io_uring_sqe& ProcReader::Ring::Next()
+{
+    const unsigned index = tail & *sqMask;
+    sqArray[index] = index;
+    ++tail;
+    ++queued;
+    io_uring_sqe& sqe = sqes[index];
+    std::memset(&sqe, 0, sizeof(sqe));
+    return sqe;
+}
+
+/**
+ * @brief Submit all queued entries and wait for their completions with
+ *        a single io_uring_enter call if possible
+ *
+ * @param[in]     expected Number of completions to wait for
+ * @param[in,out] syscalls Incremented per io_uring_enter call
+ * @param[in]     handle   Called with every completion
+ * @return false if io_uring_enter failed
+ **/
+template <typename Handle>
+bool ProcReader::Ring::Submit(unsigned expected, std::uint64_t& syscalls, Handle handle)
+{
+    __atomic_store_n(sqTail, tail, __ATOMIC_RELEASE);
+    while (expected > 0)
+    {
+        const long submitted = syscall(__NR_io_uring_enter, fd, queued, expected,
+                                       IORING_ENTER_GETEVENTS, nullptr, 0);
+        ++syscalls;
+        if (submitted < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+        queued -= static_cast<unsigned>(submitted);
+
+        unsigned head = *cqHead;
+        const unsigned last = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+        for (; head != last && expected > 0; ++head, --expected)
+        {
+            handle(cqes[head & *cqMask]);
+        }
+        __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+    }
+    return true;
+}
+
+/**
+ * @brief Construct ProcReader object with the synchronous backend
+ **/
+ProcReader::ProcReader() = default;
+
+ProcReader::~ProcReader() = default;
+
+/**
+ * @brief Switch to the io_uring backend
+ *
+ * @return false if io_uring is not available, the synchronous backend
+ *         stays active then
+ **/
+bool ProcReader::UseUring()
+{
+    auto ring = std::make_unique<Ring>();
+    if (!ring->Setup())
+    {
+        return false;
+    }
+    _ring = std::move(ring);
+    return true;
+}
+
+/**
+ * @brief Return the backend used by Read
+ **/
+ProcReader::Backend ProcReader::Active() const { return _ring ? kUring_ : kSync_; }
+
+/**
+ * @brief Return a printable name of a backend
+ **/
+const char* ProcReader::Name(Backend backend)
+{
+    return (backend == kUring_) ? "io_uring" : "sync";
+}
+
+/**
+ * @brief Return the number of syscalls issued by Read so far
+ **/
+std::uint64_t ProcReader::Syscalls() const { return _syscalls; }
+
+/**
+ * @brief Read stat and statm of all pids, no allocation happens once
+ *        samples has grown to the number of pids
+ *
+ * @param[in]  pids     Process ids
+ * @param[out] samples  One sample per pid, in the same order
+ * @param[in]  statOnly Read stat only, with open/read/close unless
+ *                      io_uring batches both files anyway
+ **/
+void ProcReader::Read(const vector<int>& pids, vector<Sample>& samples, bool statOnly)
+{
+    samples.resize(pids.size());
+    size_t done = 0;
+    while (_ring && done < pids.size())
+    {
+        const size_t count = std::min(kBatchPids, pids.size() - done);
+        if (!readUring(pids.data() + done, count, samples.data() + done))
+        {
+            // fall back for good, the batch is read again below
+            _ring.reset();
+            break;
+        }
+        done += count;
+    }
+    for (; done < pids.size(); ++done)
+    {
+        readSync(pids[done], samples[done], statOnly);
+    }
+}
+
+/**
+ * @brief Read the files of one pid with open/read/close
+ **/
+void ProcReader::readSync(int pid, Sample& sample, bool statOnly)
+{
+    const std::uint64_t before = LinuxParser::Syscalls();
+    sample.valid = LinuxParser::Stat(pid, sample.stat);
+    sample.statm = LinuxParser::ProcStatm();
+    if (sample.valid && statOnly)
+    {
+        LinuxParser::StatmOf(sample.stat, sample.statm);
+    }
+    else if (sample.valid)
+    {
+        LinuxParser::Statm(pid, sample.statm);
+    }
+    _syscalls   += LinuxParser::Syscalls() - before;
+}
+
+/**
+ * @brief Read the files of a batch of pids through io_uring: all opens
+ *        are submitted at once, then all reads each followed by a hard
+ *        linked close, so a failed read still closes its file
+ *
+ * @param[in]  pids    Process ids, at most kBatchPids
+ * @param[in]  count   Number of pids
+ * @param[out] samples One sample per pid
+ * @return false if io_uring failed or lacks an operation, nothing of the
+ *         batch is kept open then
+ **/
+bool ProcReader::readUring(const int* pids, size_t count, Sample* samples)
+{
+    Ring& ring = *_ring;
+    const size_t files = count * kFileCount_;
+
+    for (size_t slot = 0; slot < files; ++slot)
+    {
+        const int file = slot % kFileCount_;
+        snprintf(ring.paths[slot], kPathSize, "%s%d%s", LinuxParser::kProcDirectory.c_str(),
+                 pids[slot / kFileCount_],
+                 (file == kStat_) ? LinuxParser::kStatFilename.c_str()
+                                  : LinuxParser::kStatmFilename.c_str());
+        io_uring_sqe& sqe = ring.Next();
+        sqe.opcode     = IORING_OP_OPENAT;
+        sqe.fd         = AT_FDCWD;
+        sqe.addr       = reinterpret_cast<std::uint64_t>(ring.paths[slot]);
+        sqe.open_flags = O_RDONLY | O_CLOEXEC;
+        sqe.user_data  = slot;
+        ring.fds[slot]     = -1;
+        ring.lengths[slot] = -1;
+    }
+    bool unsupported = false;
+    const bool opened = ring.Submit(files, _syscalls, [&](const io_uring_cqe& cqe)
+    {
+        ring.fds[cqe.user_data] = cqe.res;
+        unsupported = unsupported || cqe.res == -EINVAL;
+    });
+
+    unsigned expected = 0;
+    for (size_t slot = 0; opened && !unsupported && slot < files; ++slot)
+    {
+        if (ring.fds[slot] < 0)
+        {
+            continue;
+        }
+        io_uring_sqe& readSqe = ring.Next();
+        readSqe.opcode    = IORING_OP_READ;
+        readSqe.fd        = ring.fds[slot];
+        readSqe.addr      = reinterpret_cast<std::uint64_t>(ring.buffers.data() + slot * kBufferSize);
+        readSqe.len       = kBufferSize;
+        readSqe.flags     = IOSQE_IO_HARDLINK;
+        readSqe.user_data = slot << 1;
+
+        io_uring_sqe& closeSqe = ring.Next();
+        closeSqe.opcode    = IORING_OP_CLOSE;
+        closeSqe.fd        = ring.fds[slot];
+        closeSqe.user_data = (slot << 1) | 1;
+        expected += 2;
+    }
+    const bool harvested = opened && !unsupported &&
+        ring.Submit(expected, _syscalls, [&](const io_uring_cqe& cqe)
+        {
+            const size_t slot = cqe.user_data >> 1;
+            if ((cqe.user_data & 1) == 0)
+            {
+                ring.lengths[slot] = cqe.res;
+            }
+            else if (cqe.res >= 0)
+            {
+                ring.fds[slot] = -1;
+            }
+        });
+    if (!harvested)
+    {
+        for (size_t slot = 0; slot < files; ++slot)
+        {
+            if (ring.fds[slot] >= 0)
+            {
+                close(ring.fds[slot]);
+                ++_syscalls;
+            }
+        }
+        return false;
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const auto content = [&](int file)
+        {
+            const size_t slot = i * kFileCount_ + file;
+            // closes are only expected to fail if the ring is torn down
+            if (ring.fds[slot] >= 0)
+            {
+                close(ring.fds[slot]);
+                ++_syscalls;
+            }
+            const int length = ring.lengths[slot];
+            return (length > 0) ? string_view(ring.buffers.data() + slot * kBufferSize, length)
+                                : string_view();
+        };
+        const string_view stat  = content(kStat_);
+        const string_view statm = content(kStatm_);
+        if (stat.size() == kBufferSize)
+        {
+            readSync(pids[i], samples[i], false);
+            continue;
+        }
+        Sample& sample = samples[i];
+        sample.valid = LinuxParser::ParseStat(stat, sample.stat);
+        sample.statm = LinuxParser::ProcStatm();
+        if (sample.valid)
+        {
+            LinuxParser::ParseStatm(statm, sample.statm);
+        }
+    }
+    return true;
+}
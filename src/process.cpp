@@ -1,5 +1,7 @@
 #include <unistd.h>
+#include <algorithm>
 #include <cctype>
+#include <chrono>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -12,17 +14,172 @@ using std::to_string;
 using std::vector;
 
 /**
- * @brief Construct Process object for appropriate process id
+ * @brief Construct Process object from values collected elsewhere,
+ *        nothing is read from /proc
  * 
- * @param[in] id A Process Id  
+ * @param[in] record Values of the process  
  **/
-Process::Process(const int id)
+Process::Process(const Record& record)
+: _id(record.pid)
+, _uid(record.uid)
+, _startTime(record.startTime)
+, _user(record.user)
+, _command(record.command)
+, _cpuUsage(record.cpu)
+, _recentCpuUsage(record.recentCpu)
+, _ram(record.ram)
+, _rss(record.rss)
+, _upTime(record.upTime)
+, _waitRate(record.waitRate)
+, _voluntaryRate(record.voluntaryRate)
+, _involuntaryRate(record.involuntaryRate)
+, _minorFaultRate(record.minorFaultRate)
+, _majorFaultRate(record.majorFaultRate)
+, _rated(record.rated)
+{
+}
+
+/**
+ * @brief Construct provisional Process object from its already read stat
+ *        and statm, user and command are left to Resolve
+ * 
+ * @param[in] id           A Process Id  
+ * @param[in] systemUpTime Uptime of the system in seconds  
+ * @param[in] stat         Parsed /proc/<pid>/stat
+ * @param[in] statm        Memory of the process
+ **/
+Process::Process(const int id, long systemUpTime, const LinuxParser::ProcStat& stat,
+                 const LinuxParser::ProcStatm& statm)
 : _id(id)
-, _user(LinuxParser::User(id))
-, _command(LinuxParser::Command(id))
+, _uid(-1)
+, _startTime(stat.startTime)
+, _user(StringPool::Users().Intern(""))
+, _command(StringPool::Commands().Intern(""))
+, _resolved(false)
+, _comm(stat.comm)
 {
-    // update cpu usage needed for sort
-    CpuUtilization();
+    Update(systemUpTime, stat, statm);
+}
+
+/**
+ * @brief Return if user and command are known, false again after the
+ *        process called exec until Resolve
+ **/
+bool Process::Resolved() const { return _resolved; }
+
+/**
+ * @brief Set user and command of a provisional process
+ * 
+ * @param[in] uid     User id, -1 if unknown
+ * @param[in] user    Handle into StringPool::Users()
+ * @param[in] command Handle into StringPool::Commands()
+ **/
+void Process::Resolve(int uid, StringPool::Handle user, StringPool::Handle command)
+{
+    _uid      = uid;
+    _user     = user;
+    _command  = command;
+    _resolved = true;
+}
+
+/**
+ * @brief Refresh cpu usage, memory and age of this process from values
+ *        read elsewhere, e.g. by a ProcReader
+ * 
+ * @param[in] systemUpTime Uptime of the system in seconds  
+ * @param[in] stat         Parsed /proc/<pid>/stat
+ * @param[in] statm        Parsed /proc/<pid>/statm
+ * @return false if the pid belongs to another process by now
+ **/
+bool Process::Update(long systemUpTime, const LinuxParser::ProcStat& stat,
+                     const LinuxParser::ProcStatm& statm)
+{
+   if (stat.startTime != _startTime)
+   {
+      return false;
+   }
+   // exec keeps pid and start time, but changes the command name and
+   // possibly the uid; the previous ones are kept until Resolve
+   if (stat.comm != _comm)
+   {
+      _comm     = stat.comm;
+      _resolved = false;
+   }
+   _upTime = systemUpTime - _startTime / sysconf(_SC_CLK_TCK);
+
+   const long totalTimeActive  = stat.activeJiffies / sysconf(_SC_CLK_TCK);
+   _cpuUsage = (_upTime > 0) ? static_cast<float>(totalTimeActive) / static_cast<float>(_upTime) : 0.0;
+
+   // share since the previous Update, the lifetime share until there is one
+   const auto now = static_cast<std::uint64_t>(
+       std::chrono::duration_cast<std::chrono::nanoseconds>(
+           std::chrono::steady_clock::now().time_since_epoch()).count());
+   if (_updatedAt != 0 && now > _updatedAt)
+   {
+      const float seconds = static_cast<float>(now - _updatedAt) / 1e9f;
+      const float active  = static_cast<float>(stat.activeJiffies - _activeJiffies) /
+                            static_cast<float>(sysconf(_SC_CLK_TCK));
+      _recentCpuUsage = std::max(0.0f, active / seconds);
+   }
+   else
+   {
+      _recentCpuUsage = _cpuUsage;
+   }
+   _activeJiffies = stat.activeJiffies;
+   _updatedAt     = now;
+
+   _ram = statm.size;
+   _rss = statm.resident;
+
+   // rates are only valid in ticks this process is sampled
+   _minorFaults     = stat.minorFaults;
+   _majorFaults     = stat.majorFaults;
+   _waitRate        = 0;
+   _voluntaryRate   = 0;
+   _involuntaryRate = 0;
+   _minorFaultRate  = 0;
+   _majorFaultRate  = 0;
+   _rated           = false;
+   return true;
+}
+
+/**
+ * @brief Sample scheduler latency, context switches and faults as rates
+ *        since the previous Sample. Reads two more files, so it is meant
+ *        for a bounded set of processes only and expected after Update.
+ * 
+ * @param[in] now Monotonic time in ns
+ **/
+void Process::Sample(std::uint64_t now)
+{
+   LinuxParser::ProcStatus status;
+   if (now == _sampledAt || !LinuxParser::Status(_id, status))
+   {
+      return;
+   }
+   LinuxParser::ProcSchedstat schedstat;
+   const bool hasSchedstat = LinuxParser::Schedstat(_id, schedstat);
+
+   if (_sampledAt != 0)
+   {
+      const float seconds = static_cast<float>(now - _sampledAt) / 1e9f;
+      const auto rate = [&](long current, long previous)
+      {
+         return static_cast<float>(current - previous) / seconds;
+      };
+      _waitRate        = hasSchedstat ? rate(schedstat.waitNs, _sampledWaitNs) / 1e6f : 0;
+      _voluntaryRate   = rate(status.voluntarySwitches, _sampledVoluntary);
+      _involuntaryRate = rate(status.involuntarySwitches, _sampledInvoluntary);
+      _minorFaultRate  = rate(_minorFaults, _sampledMinorFaults);
+      _majorFaultRate  = rate(_majorFaults, _sampledMajorFaults);
+      _rated           = true;
+   }
+   _sampledAt          = now;
+   _sampledWaitNs      = schedstat.waitNs;
+   _sampledVoluntary   = status.voluntarySwitches;
+   _sampledInvoluntary = status.involuntarySwitches;
+   _sampledMinorFaults = _minorFaults;
+   _sampledMajorFaults = _majorFaults;
 }
 
 /**
@@ -30,45 +187,95 @@ Process::Process(const int id)
  **/
 int Process::Pid() const { return _id; }
 
+/**
+ * @brief Return the user ID of this process
+ **/
+int Process::Uid() const { return _uid; }
+
+/**
+ * @brief Return the start time in jiffies after boot, together with
+ *        the pid it identifies a process
+ **/
+long Process::StartTime() const { return _startTime; }
+
+/**
+ * @brief Return the time spent waiting on a run queue in ms per second,
+ *        0 if not sampled in the latest tick
+ **/
+float Process::WaitRate() const { return _waitRate; }
+
+/**
+ * @brief Return the voluntary context switches per second
+ **/
+float Process::VoluntarySwitchRate() const { return _voluntaryRate; }
+
+/**
+ * @brief Return the involuntary context switches per second
+ **/
+float Process::InvoluntarySwitchRate() const { return _involuntaryRate; }
+
+/**
+ * @brief Return the minor page faults per second
+ **/
+float Process::MinorFaultRate() const { return _minorFaultRate; }
+
+/**
+ * @brief Return the major page faults per second
+ **/
+float Process::MajorFaultRate() const { return _majorFaultRate; }
+
+/**
+ * @brief Return whether the rates were sampled in the latest tick,
+ *        otherwise they read 0 without meaning no activity
+ **/
+bool Process::Rated() const { return _rated; }
+
 /**
  * @brief Return this process's CPU utilization
  **/
-float Process::CpuUtilization() 
-{ 
-   const long totalTimeActive  = LinuxParser::ActiveJiffies(_id)/ sysconf(_SC_CLK_TCK);
+float Process::CpuUtilization() const { return _cpuUsage; }
 
-   _cpuUsage = static_cast<float>(totalTimeActive) / static_cast<float>(UpTime());
-   return _cpuUsage; 
-}
+/**
+ * @brief Return this process's CPU utilization since the previous Update
+ **/
+float Process::RecentCpuUtilization() const { return _recentCpuUsage; }
 
 /**
  * @brief Return the command that generated this process
  *  Note: The cutoff of command is implemented in format.cpp see Format::Command
  **/
-string Process::Command() const { return _command; }
+string Process::Command() const { return string(StringPool::Commands().Get(_command)); }
+
+/**
+ * @brief Return the handle of the interned command,
+ *        equal commands have equal handles
+ **/
+StringPool::Handle Process::CommandHandle() const { return _command; }
 
 /**
  * @brief Return this process's memory utilization
  **/
-int Process::Ram() 
-{ 
-    return LinuxParser::Ram(_id); 
-}
+int Process::Ram() const { return _ram; }
+
+/**
+ * @brief Return this process's resident memory in mb
+ **/
+int Process::Rss() const { return _rss; }
 
 /**
  * @brief Return the user (name) that generated this process
  **/
-string Process::User() const { return _user; }
+string Process::User() const { return string(StringPool::Users().Get(_user)); }
+
+/**
+ * @brief Return the handle of the interned user name
+ **/
+StringPool::Handle Process::UserHandle() const { return _user; }
 
 /**
  * @brief Return the age of this process (in seconds)
  **/
-long int Process::UpTime() 
-{ 
-   const long systemUpTime     = LinuxParser::UpTime();
-   const long processUpTime    = LinuxParser::UpTime(_id);
-   return systemUpTime - processUpTime;
-}
+long int Process::UpTime() const { return _upTime; }
 
 /**
  * @brief "less than" comparison operator for Process objects
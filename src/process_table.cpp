@@ -0,0 +1,622 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "linux_parser.h"
+#include "process.h"
+#include "process_table.h"
+#include "profiler.h"
+
+using std::size_t;
+using std::string;
+using std::vector;
+
+/**
+ * @brief Release the commands of all rows
+ **/
+ProcessTable::~ProcessTable()
+{
+    for (const auto command : _commands)
+    {
+        StringPool::Commands().Release(command);
+    }
+}
+
+/**
+ * @brief Refresh the table: update known processes, add new ones and
+ *        drop the ones which are gone
+ *
+ * @param[in] pids        Ids of all current processes
+ * @param[in] provisional Read stat only and leave user and command of new
+ *                        processes to Resolve or the next Update
+ **/
+void ProcessTable::Update(const vector<int>& pids, bool provisional)
+{
+    ++_generation;
+    _added = 0;
+    _removedRules.clear();
+    // commands released by the previous Update are no longer reported
+    StringPool::Commands().Collect();
+    const long systemUpTime = LinuxParser::UpTime();
+    {
+        PROFILE_SCOPE(Profiler::kReadPids_);
+        _reader.Read(pids, _samples, provisional);
+    }
+
+    for (size_t i = 0; i < pids.size(); ++i)
+    {
+        PROFILE_SCOPE(Profiler::kParsePid_);
+        const int pid = pids[i];
+        const ProcReader::Sample& sample = _samples[i];
+        const auto found = _rowOfPid.find(pid);
+        if (found != _rowOfPid.end())
+        {
+            const size_t row = found->second;
+            const bool resolved = _processes[row].Resolved();
+            if (sample.valid && _processes[row].Update(systemUpTime, sample.stat, sample.statm))
+            {
+                // the process called exec, resolved again below
+                _pending += resolved && !_processes[row].Resolved();
+                updateValues(row);
+                _seen[row] = _generation;
+                continue;
+            }
+            // pid was reused by another process
+            remove(row);
+        }
+        if (sample.valid)
+        {
+            // built from the sample, nothing is read twice
+            insert(Process(pid, systemUpTime, sample.stat, sample.statm));
+            ++_added;
+        }
+    }
+    removeUnseen();
+
+    for (size_t row = 0; !provisional && _pending > 0 && row < _processes.size(); ++row)
+    {
+        resolve(row);
+    }
+}
+
+/**
+ * @brief Refresh the table from processes collected elsewhere,
+ *        e.g. read from a published snapshot
+ *
+ * @param[in] processes All current processes
+ **/
+void ProcessTable::Update(const vector<Process>& processes)
+{
+    ++_generation;
+    _added = 0;
+    _removedRules.clear();
+    StringPool::Commands().Collect();
+
+    for (const auto& process : processes)
+    {
+        const auto found = _rowOfPid.find(process.Pid());
+        if (found != _rowOfPid.end())
+        {
+            const size_t row = found->second;
+            if (_processes[row].StartTime() == process.StartTime())
+            {
+                // the uid changes after exec of a setuid binary
+                const bool moved = _processes[row].Uid() != process.Uid();
+                if (moved)
+                {
+                    removeFromBucket(row);
+                }
+                _processes[row] = process;
+                if (moved)
+                {
+                    addToBucket(row);
+                }
+                _seen[row] = _generation;
+                _users[row] = process.UserHandle();
+                setCommand(row, process.CommandHandle());
+                updateValues(row);
+                continue;
+            }
+            remove(row);
+        }
+        insert(Process(process));
+        ++_added;
+    }
+    removeUnseen();
+}
+
+/**
+ * @brief Sample scheduler and fault rates of some processes, all others
+ *        report 0 for this tick
+ *
+ * @param[in] pids Processes to sample, e.g. the visible and top ones;
+ *                 unknown pids and duplicates are ignored
+ **/
+void ProcessTable::Sample(const vector<int>& pids)
+{
+    PROFILE_SCOPE(Profiler::kSample_);
+    const auto now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    for (const auto pid : pids)
+    {
+        const auto found = _rowOfPid.find(pid);
+        if (found != _rowOfPid.end())
+        {
+            _processes[found->second].Sample(static_cast<std::uint64_t>(now));
+            updateValues(found->second);
+        }
+    }
+}
+
+/**
+ * @brief Look up user and command of provisional processes
+ *
+ * @param[in] pids Processes to resolve, e.g. the visible ones; unknown
+ *                 and resolved pids are ignored
+ **/
+void ProcessTable::Resolve(const vector<int>& pids)
+{
+    for (size_t i = 0; _pending > 0 && i < pids.size(); ++i)
+    {
+        const auto found = _rowOfPid.find(pids[i]);
+        if (found != _rowOfPid.end())
+        {
+            resolve(found->second);
+        }
+    }
+}
+
+/**
+ * @brief Return number of processes added by the last Update
+ **/
+size_t ProcessTable::Added() const { return _added; }
+
+/**
+ * @brief Return number of processes whose user and command are unknown
+ **/
+size_t ProcessTable::Pending() const { return _pending; }
+
+/**
+ * @brief Return the reader of per process files, e.g. to switch backends
+ **/
+ProcReader& ProcessTable::Reader() { return _reader; }
+
+/**
+ * @brief Return all processes, in no particular order
+ **/
+vector<Process>& ProcessTable::Processes() { return _processes; }
+
+/**
+ * @brief Return number of processes
+ **/
+size_t ProcessTable::Size() const { return _processes.size(); }
+
+/**
+ * @brief Look up a process by its id
+ *
+ * @param[in] pid Process id
+ * @return pointer to process, nullptr if unknown
+ **/
+const Process* ProcessTable::Find(int pid) const
+{
+    const auto found = _rowOfPid.find(pid);
+    return (found == _rowOfPid.end()) ? nullptr : &_processes[found->second];
+}
+
+/**
+ * @brief Select the rows matching the filters of a view, sorted
+ *        by the view's sort key
+ *
+ * @param[in]  view Filters and sort order
+ * @param[out] rows Indices into Processes()
+ * @return false if the command regex is invalid (filter is ignored then)
+ **/
+bool ProcessTable::Select(const View& view, vector<int>& rows)
+{
+    const bool valid = updateCommandFilter(view);
+    const bool filterCommand = valid && !_commandFilter.empty();
+
+    rows.clear();
+    const auto add = [&](size_t row)
+    {
+        if (!filterCommand || commandMatches(_commands[row]))
+        {
+            rows.push_back(static_cast<int>(row));
+        }
+    };
+
+    if (view.user.empty())
+    {
+        for (size_t row = 0; row < _processes.size(); ++row)
+        {
+            add(row);
+        }
+    }
+    else
+    {
+        // only visit the buckets of matching users
+        for (const auto& bucket : _userBuckets)
+        {
+            if (userMatches(bucket.first, view.user))
+            {
+                for (const auto row : bucket.second)
+                {
+                    add(row);
+                }
+            }
+        }
+    }
+
+    PROFILE_SCOPE(Profiler::kSort_);
+    const auto& p = _processes;
+    const StringPool& pool  = StringPool::Commands();
+    const StringPool& users = StringPool::Users();
+    const auto less = [&](int a, int b)
+    {
+        switch (view.sort)
+        {
+            case kSortCpu_:     return p[b].CpuUtilization() < p[a].CpuUtilization();
+            case kSortRam_:     return p[b].Ram() < p[a].Ram();
+            case kSortTime_:    return p[b].UpTime() < p[a].UpTime();
+            case kSortWait_:    return p[b].WaitRate() < p[a].WaitRate();
+            case kSortSwitches_:
+                return p[b].VoluntarySwitchRate() + p[b].InvoluntarySwitchRate() <
+                       p[a].VoluntarySwitchRate() + p[a].InvoluntarySwitchRate();
+            case kSortFaults_:
+                return p[b].MinorFaultRate() + p[b].MajorFaultRate() <
+                       p[a].MinorFaultRate() + p[a].MajorFaultRate();
+            case kSortUser_:    return users.Get(p[a].UserHandle()) < users.Get(p[b].UserHandle());
+            case kSortCommand_: return p[a].CommandHandle() != p[b].CommandHandle() &&
+                                       pool.Get(p[a].CommandHandle()) < pool.Get(p[b].CommandHandle());
+            case kSortPid_:     break;
+        }
+        return p[a].Pid() < p[b].Pid();
+    };
+    std::sort(rows.begin(), rows.end(), [&](int a, int b)
+    {
+        // ties are ordered by pid, so rows do not jump between ticks
+        const bool aFirst = less(a, b);
+        const bool bFirst = less(b, a);
+        if (aFirst == bFirst)
+        {
+            return p[a].Pid() < p[b].Pid();
+        }
+        return view.reverse ? bFirst : aFirst;
+    });
+    return valid;
+}
+
+/**
+ * @brief Return the rows of the n processes with the highest cpu usage
+ *        since the previous Update
+ *
+ * @param[in]  n    Max number of rows
+ * @param[out] rows Indices into Processes(), highest first
+ **/
+void ProcessTable::Top(size_t n, vector<int>& rows) const
+{
+    rows.resize(_processes.size());
+    for (size_t row = 0; row < rows.size(); ++row)
+    {
+        rows[row] = static_cast<int>(row);
+    }
+    n = std::min(n, rows.size());
+    const float* cpu = _values[kColumnCpu_].data();
+    std::partial_sort(rows.begin(), rows.begin() + n, rows.end(),
+        [&](int a, int b) { return cpu[b] < cpu[a]; });
+    rows.resize(n);
+}
+
+/**
+ * @brief Return the values of all rows for one column
+ *
+ * @param[in] column Which value
+ * @return one entry per row of Processes()
+ **/
+const float* ProcessTable::Values(Column column) const { return _values[column].data(); }
+
+/**
+ * @brief Return the user handles of all rows, one entry per row
+ **/
+const StringPool::Handle* ProcessTable::Users() const { return _users.data(); }
+
+/**
+ * @brief Set the number of rule state columns, new columns start at 0
+ *
+ * @param[in] rules Number of process rules
+ **/
+void ProcessTable::ResizeRuleState(size_t rules)
+{
+    _ruleFlags.resize(rules);
+    _ruleSince.resize(rules);
+    for (size_t rule = 0; rule < rules; ++rule)
+    {
+        _ruleFlags[rule].resize(_processes.size(), 0);
+        _ruleSince[rule].resize(_processes.size(), 0);
+    }
+}
+
+/**
+ * @brief Return the state columns of a rule, one entry per row
+ *
+ * @param[in] rule Index below the count of ResizeRuleState
+ **/
+ProcessTable::RuleState ProcessTable::Rule(size_t rule)
+{
+    return {_ruleFlags[rule].data(), _ruleSince[rule].data()};
+}
+
+/**
+ * @brief Return the rule state of the rows removed by the last Update,
+ *        so a rule holding for a process that is gone can be resolved
+ **/
+const vector<ProcessTable::RemovedRule>& ProcessTable::RemovedRules() const { return _removedRules; }
+
+/**
+ * @brief Append a process and register it in all indices
+ **/
+void ProcessTable::insert(Process&& process)
+{
+    const size_t row = _processes.size();
+
+    _commands.push_back(process.CommandHandle());
+    // see setCommand
+    StringPool::Commands().Retain(process.CommandHandle());
+    if (process.CommandHandle() < _commandMatches.size())
+    {
+        _commandMatches[process.CommandHandle()] = -1;
+    }
+    _users.push_back(process.UserHandle());
+    for (auto& column : _values)
+    {
+        column.push_back(0);
+    }
+
+    _bucketPositions.push_back(0);
+    if (process.Resolved() && process.Uid() >= 0)
+    {
+        _userNames.try_emplace(process.Uid(), process.UserHandle());
+    }
+    _pending += !process.Resolved();
+
+    _seen.push_back(_generation);
+    for (size_t rule = 0; rule < _ruleFlags.size(); ++rule)
+    {
+        _ruleFlags[rule].push_back(0);
+        _ruleSince[rule].push_back(0);
+    }
+    _rowOfPid[process.Pid()] = row;
+    _processes.push_back(std::move(process));
+    addToBucket(row);
+    updateValues(row);
+}
+
+/**
+ * @brief Look up user and command of a provisional row or of a process
+ *        which called exec, the user name is looked up once per uid
+ **/
+void ProcessTable::resolve(size_t row)
+{
+    Process& process = _processes[row];
+    if (process.Resolved())
+    {
+        return;
+    }
+    PROFILE_SCOPE(Profiler::kResolve_);
+    LinuxParser::ProcStatus status;
+    const int uid = LinuxParser::Status(process.Pid(), status) ? static_cast<int>(status.uid) : -1;
+    StringPool::Handle user = process.UserHandle();
+    if (uid >= 0)
+    {
+        auto name = _userNames.find(uid);
+        if (name == _userNames.end())
+        {
+            name = _userNames.emplace(uid, StringPool::Users().Intern(LinuxParser::UserName(uid))).first;
+        }
+        user = name->second;
+    }
+    const StringPool::Handle command =
+        StringPool::Commands().Intern(LinuxParser::Command(process.Pid()));
+
+    removeFromBucket(row);
+    process.Resolve(uid, user, command);
+    addToBucket(row);
+    _users[row] = user;
+    setCommand(row, command);
+    --_pending;
+}
+
+/**
+ * @brief Append a row to the bucket of its user
+ **/
+void ProcessTable::addToBucket(size_t row)
+{
+    auto& bucket = _userBuckets[_processes[row].Uid()];
+    _bucketPositions[row] = bucket.size();
+    bucket.push_back(row);
+}
+
+/**
+ * @brief Remove a row from the bucket of its user by moving the last
+ *        entry of the bucket into its place
+ **/
+void ProcessTable::removeFromBucket(size_t row)
+{
+    auto& bucket = _userBuckets[_processes[row].Uid()];
+    const size_t position = _bucketPositions[row];
+    bucket[position] = bucket.back();
+    _bucketPositions[bucket[position]] = position;
+    bucket.pop_back();
+}
+
+/**
+ * @brief Copy the numeric values of a row into the columns
+ **/
+void ProcessTable::updateValues(size_t row)
+{
+    const Process& p = _processes[row];
+    _values[kColumnCpu_][row]      = p.RecentCpuUtilization();
+    _values[kColumnRam_][row]      = static_cast<float>(p.Ram());
+    _values[kColumnRss_][row]      = static_cast<float>(p.Rss());
+    _values[kColumnWait_][row]     = p.WaitRate();
+    _values[kColumnSwitches_][row] = p.VoluntarySwitchRate() + p.InvoluntarySwitchRate();
+    _values[kColumnFaults_][row]   = p.MinorFaultRate() + p.MajorFaultRate();
+}
+
+/**
+ * @brief Remove all rows not seen by the current Update
+ **/
+void ProcessTable::removeUnseen()
+{
+    // rows behind the current one were already checked, so swapping
+    // the last row into a removed one is safe while going backwards
+    for (size_t row = _processes.size(); row-- > 0;)
+    {
+        if (_seen[row] != _generation)
+        {
+            remove(row);
+        }
+    }
+}
+
+/**
+ * @brief Remove a row by moving the last row into its place
+ **/
+void ProcessTable::remove(size_t row)
+{
+    const size_t last = _processes.size() - 1;
+
+    removeFromBucket(row);
+    _pending -= !_processes[row].Resolved();
+    for (size_t rule = 0; rule < _ruleFlags.size(); ++rule)
+    {
+        if (_ruleFlags[rule][row] != 0)
+        {
+            _removedRules.push_back({rule, _ruleFlags[rule][row], _processes[row].Pid(),
+                                     _users[row], _commands[row]});
+        }
+    }
+
+    // evicted by the next Update, after events of this one got reported
+    StringPool::Commands().Release(_commands[row]);
+    _rowOfPid.erase(_processes[row].Pid());
+    if (row != last)
+    {
+        _processes[row]       = std::move(_processes[last]);
+        _commands[row]        = _commands[last];
+        _users[row]           = _users[last];
+        _bucketPositions[row] = _bucketPositions[last];
+        _seen[row]            = _seen[last];
+        for (auto& column : _values)
+        {
+            column[row] = column[last];
+        }
+        for (size_t rule = 0; rule < _ruleFlags.size(); ++rule)
+        {
+            _ruleFlags[rule][row] = _ruleFlags[rule][last];
+            _ruleSince[rule][row] = _ruleSince[rule][last];
+        }
+        _userBuckets[_processes[row].Uid()][_bucketPositions[row]] = row;
+        _rowOfPid[_processes[row].Pid()] = row;
+    }
+    _processes.pop_back();
+    _commands.pop_back();
+    _users.pop_back();
+    for (auto& column : _values)
+    {
+        column.pop_back();
+    }
+    _bucketPositions.pop_back();
+    _seen.pop_back();
+    for (size_t rule = 0; rule < _ruleFlags.size(); ++rule)
+    {
+        _ruleFlags[rule].pop_back();
+        _ruleSince[rule].pop_back();
+    }
+}
+
+/**
+ * @brief Replace the command of a row. The cached filter result of a
+ *        handle is dropped whenever a row takes it, it may have been
+ *        evicted and reused for another command meanwhile.
+ **/
+void ProcessTable::setCommand(size_t row, StringPool::Handle command)
+{
+    if (_commands[row] == command)
+    {
+        return;
+    }
+    StringPool::Commands().Retain(command);
+    StringPool::Commands().Release(_commands[row]);
+    _commands[row] = command;
+    if (command < _commandMatches.size())
+    {
+        _commandMatches[command] = -1;
+    }
+}
+
+/**
+ * @brief Take over the command filter of a view, cached results are
+ *        dropped only if the filter changed
+ *
+ * @return false if the regex is invalid
+ **/
+bool ProcessTable::updateCommandFilter(const View& view)
+{
+    if (view.command == _commandFilter && view.regex == _commandFilterRegex)
+    {
+        return _commandFilterValid;
+    }
+    _commandFilter      = view.command;
+    _commandFilterRegex = view.regex;
+    _commandFilterValid = true;
+    _commandMatches.clear();
+    if (_commandFilterRegex && !_commandFilter.empty())
+    {
+        try
+        {
+            _commandRegex = std::regex(_commandFilter, std::regex::optimize);
+        }
+        catch (const std::regex_error&)
+        {
+            _commandFilterValid = false;
+        }
+    }
+    return _commandFilterValid;
+}
+
+/**
+ * @brief Return if an interned command matches the current filter,
+ *        each distinct command is evaluated only once per filter
+ **/
+bool ProcessTable::commandMatches(StringPool::Handle command)
+{
+    const StringPool& pool = StringPool::Commands();
+    if (command >= _commandMatches.size())
+    {
+        _commandMatches.resize(pool.Size(), -1);
+    }
+    auto& match = _commandMatches[command];
+    if (match < 0)
+    {
+        const std::string_view text = pool.Get(command);
+        match = _commandFilterRegex ? std::regex_search(text.begin(), text.end(), _commandRegex)
+                                    : text.find(_commandFilter) != std::string_view::npos;
+    }
+    return match > 0;
+}
+
+/**
+ * @brief Return if the name of a user contains the filter
+ **/
+bool ProcessTable::userMatches(int uid, const string& user)
+{
+    const auto name = _userNames.find(uid);
+    return name != _userNames.end() &&
+           StringPool::Users().Get(name->second).find(user) != std::string_view::npos;
+}
@@ -4,11 +4,23 @@
 #include <vector>
 
 /**
- * @brief Construct Processor object
+ * @brief Construct Processor object without reading anything, so the
+ *        first utilization is the one since boot
  **/
 Processor::Processor()
+: _prevIdleJiffies(0)
+, _prevTotalJiffies(0)
+{
+}
+
+/**
+ * @brief Construct Processor object from already read jiffies,
+ *        used for single cores
+ *
+ * @param[in] jiffies A vector with jiffies values from cpu
+ **/
+Processor::Processor(const std::vector<long>& jiffies)
 {
-    const std::vector<long> jiffies = LinuxParser::CpuUtilization();
     _prevIdleJiffies   = LinuxParser::IdleJiffies(jiffies);   
     _prevTotalJiffies  = LinuxParser::Jiffies(jiffies);
 }
@@ -19,7 +31,16 @@ Processor::Processor()
 float Processor::Utilization() 
 { 
     // get current jiffies from file 
-    const std::vector<long> jiffies = LinuxParser::CpuUtilization();
+    return Utilization(LinuxParser::CpuUtilization());
+}
+
+/**
+ * @brief Return the CPU utilization since the previous call
+ *
+ * @param[in] jiffies A vector with current jiffies values from cpu
+ **/
+float Processor::Utilization(const std::vector<long>& jiffies) 
+{ 
     const auto currentIdleJiffies   = LinuxParser::IdleJiffies(jiffies);
     const auto currentTotalJiffies  = LinuxParser::Jiffies(jiffies);  
     
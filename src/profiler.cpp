@@ -0,0 +1,275 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include "format.h"
+#include "profiler.h"
+
+using std::string;
+using std::uint64_t;
+using std::vector;
+
+namespace {
+// log-linear buckets: 4 sub-buckets per power of two, max error 12.5%
+constexpr int kSubBits    = 2;
+constexpr int kSubBuckets = 1 << kSubBits;
+constexpr int kBuckets    = (64 - kSubBits + 1) * kSubBuckets;
+constexpr int kSeries     = Profiler::kStageCount_ + Profiler::kCounterCount_;
+constexpr int kMaxThreads = 16;
+
+// written by its owning thread, read by anyone reporting
+struct ThreadHistograms {
+  std::atomic<uint64_t> buckets[kSeries][kBuckets];
+};
+
+ThreadHistograms threadHistograms[kMaxThreads];
+std::atomic<int> registeredThreads{0};
+
+/**
+ * @brief Return the histograms of the calling thread, the slot is claimed
+ *        on first use. Threads beyond kMaxThreads share the last slot.
+ **/
+ThreadHistograms& local()
+{
+  thread_local ThreadHistograms* histograms = nullptr;
+  if (histograms == nullptr)
+  {
+    const int slot = registeredThreads.fetch_add(1, std::memory_order_relaxed);
+    histograms = &threadHistograms[slot < kMaxThreads ? slot : kMaxThreads - 1];
+  }
+  return *histograms;
+}
+
+int bucketIndex(uint64_t value)
+{
+  if (value < kSubBuckets)
+  {
+    return static_cast<int>(value);
+  }
+  const int msb = 63 - __builtin_clzll(value);
+  const int sub = static_cast<int>(value >> (msb - kSubBits)) & (kSubBuckets - 1);
+  return (msb - kSubBits + 1) * kSubBuckets + sub;
+}
+
+/**
+ * @brief Return the middle of a bucket
+ **/
+uint64_t bucketValue(int index)
+{
+  if (index < kSubBuckets)
+  {
+    return index;
+  }
+  const int msb   = index / kSubBuckets + kSubBits - 1;
+  const int sub   = index % kSubBuckets;
+  const uint64_t lower = static_cast<uint64_t>(kSubBuckets + sub) << (msb - kSubBits);
+  return lower + (uint64_t{1} << (msb - kSubBits)) / 2;
+}
+
+void record(int series, uint64_t value)
+{
+  local().buckets[series][bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+}
+
+Profiler::Percentiles summarize(int series)
+{
+  uint64_t counts[kBuckets] = {};
+  Profiler::Percentiles result;
+  for (const auto& thread : threadHistograms)
+  {
+    for (int i = 0; i < kBuckets; ++i)
+    {
+      const uint64_t count = thread.buckets[series][i].load(std::memory_order_relaxed);
+      counts[i]    += count;
+      result.count += count;
+    }
+  }
+
+  const uint64_t rank50 = (result.count * 50 + 99) / 100;
+  const uint64_t rank99 = (result.count * 99 + 99) / 100;
+  uint64_t seen = 0;
+  // the lowest bucket's value is 0, so 0 cannot mean "not found yet"
+  bool found50 = false;
+  bool found99 = false;
+  for (int i = 0; i < kBuckets; ++i)
+  {
+    if (counts[i] == 0)
+    {
+      continue;
+    }
+    seen += counts[i];
+    if (!found50 && seen >= rank50)
+    {
+      result.p50 = bucketValue(i);
+      found50    = true;
+    }
+    if (!found99 && seen >= rank99)
+    {
+      result.p99 = bucketValue(i);
+      found99    = true;
+    }
+    result.max = bucketValue(i);
+  }
+  return result;
+}
+
+/**
+ * @brief Read syscall and byte counters of this process from /proc/self/io
+ *
+ * @param[out] readSyscalls Number of read syscalls (syscr)
+ * @param[out] bytesRead    Number of bytes read (rchar)
+ **/
+void readIoCounters(uint64_t& readSyscalls, uint64_t& bytesRead)
+{
+  char buffer[512];
+  readSyscalls = 0;
+  bytesRead    = 0;
+  const int fd = open("/proc/self/io", O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+  {
+    return;
+  }
+  const ssize_t size = read(fd, buffer, sizeof(buffer) - 1);
+  close(fd);
+  if (size <= 0)
+  {
+    return;
+  }
+  buffer[size] = '\0';
+  const char* rchar = std::strstr(buffer, "rchar:");
+  const char* syscr = std::strstr(buffer, "syscr:");
+  if (rchar != nullptr) bytesRead    = std::strtoull(rchar + 6, nullptr, 10);
+  if (syscr != nullptr) readSyscalls = std::strtoull(syscr + 6, nullptr, 10);
+}
+
+string formatCount(uint64_t value)
+{
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%9llu", static_cast<unsigned long long>(value));
+  return string(buffer);
+}
+}  // namespace
+
+/**
+ * @brief Return a monotonic timestamp in nanoseconds, not affected by NTP
+ **/
+uint64_t Profiler::Now()
+{
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC_RAW, &now);
+  return static_cast<uint64_t>(now.tv_sec) * 1000000000ull + now.tv_nsec;
+}
+
+/**
+ * @brief Record the duration of a stage
+ **/
+void Profiler::Record(Stage stage, uint64_t nanoseconds) { record(stage, nanoseconds); }
+
+/**
+ * @brief Record the value of a per tick counter
+ **/
+void Profiler::Record(Counter counter, uint64_t value) { record(kStageCount_ + counter, value); }
+
+/**
+ * @brief Return the percentiles of a stage over all threads (nanoseconds)
+ **/
+Profiler::Percentiles Profiler::Summarize(Stage stage) { return summarize(stage); }
+
+/**
+ * @brief Return the percentiles of a per tick counter over all threads
+ **/
+Profiler::Percentiles Profiler::Summarize(Counter counter) { return summarize(kStageCount_ + counter); }
+
+/**
+ * @brief Return true if the instrumentation is compiled in
+ **/
+bool Profiler::Enabled()
+{
+#ifdef MONITOR_PROFILING
+  return true;
+#else
+  return false;
+#endif
+}
+
+/**
+ * @brief Return a table with p50/p99/max of every stage and counter
+ **/
+vector<string> Profiler::Report()
+{
+  static const char* const stageNames[kStageCount_] = {
+    "tick", "pids", "read pids", "parse pid", "resolve", "user lookup", "sample sched",
+    "sort", "display system", "display procs", "display status", "display numa",
+    "display self"};
+  static const char* const counterNames[kCounterCount_] = {
+    "read syscalls/tick", "bytes read/tick"};
+
+  vector<string> lines;
+  if (!Enabled())
+  {
+    lines.emplace_back("self profiling is not compiled in (MONITOR_PROFILING=OFF)");
+    return lines;
+  }
+
+  char line[128];
+  snprintf(line, sizeof(line), "%-20s%9s%9s%9s%9s", "STAGE", "COUNT", "P50", "P99", "MAX");
+  lines.emplace_back(line);
+  for (int stage = 0; stage < kStageCount_; ++stage)
+  {
+    const Percentiles p = Summarize(static_cast<Stage>(stage));
+    snprintf(line, sizeof(line), "%-20s%s%9s%9s%9s", stageNames[stage], formatCount(p.count).c_str(),
+             Format::Duration(p.p50).c_str(), Format::Duration(p.p99).c_str(),
+             Format::Duration(p.max).c_str());
+    lines.emplace_back(line);
+  }
+  for (int counter = 0; counter < kCounterCount_; ++counter)
+  {
+    const Percentiles p = Summarize(static_cast<Counter>(counter));
+    snprintf(line, sizeof(line), "%-20s%s%s%s%s", counterNames[counter], formatCount(p.count).c_str(),
+             formatCount(p.p50).c_str(), formatCount(p.p99).c_str(), formatCount(p.max).c_str());
+    lines.emplace_back(line);
+  }
+  return lines;
+}
+
+/**
+ * @brief Start timing a stage
+ **/
+Profiler::ScopedTimer::ScopedTimer(Stage stage)
+: _stage(stage)
+, _start(Now())
+{
+}
+
+/**
+ * @brief Stop timing and record the duration
+ **/
+Profiler::ScopedTimer::~ScopedTimer() { Record(_stage, Now() - _start); }
+
+/**
+ * @brief Start timing a tick and take the io counters
+ **/
+Profiler::ScopedTick::ScopedTick()
+: _timer(kTick_)
+{
+  readIoCounters(_readSyscalls, _bytesRead);
+}
+
+/**
+ * @brief Record the io done during the tick, the read of
+ *        /proc/self/io itself is included (one syscall)
+ **/
+Profiler::ScopedTick::~ScopedTick()
+{
+  uint64_t readSyscalls, bytesRead;
+  readIoCounters(readSyscalls, bytesRead);
+  Record(kReadSyscalls_, readSyscalls - _readSyscalls);
+  Record(kBytesRead_, bytesRead - _bytesRead);
+}
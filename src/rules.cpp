@@ -0,0 +1,652 @@
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "format.h"
+#include "process.h"
+#include "process_table.h"
+#include "rules.h"
+#include "string_pool.h"
+#include "system.h"
+
+using std::size_t;
+using std::string;
+using std::uint32_t;
+using std::vector;
+
+namespace {
+// state of a rule per process, or of a system rule: flags, scanned every
+// tick, and the second it started holding, only read when flags change
+constexpr std::uint8_t kHolding = 1;
+constexpr std::uint8_t kFired   = 2;  // the event was raised
+
+// rows are checked in blocks, all rules of one metric run over a block
+// before the next, so its values stay in cache and only the state columns
+// stream from memory. Per rule a branch free pass, which the compiler can
+// vectorize, tells if the state of any row changes, i.e. a row holds and
+// did not fire yet or stopped holding. Only then the block is visited row
+// by row, for most blocks of most rules it is not.
+constexpr size_t kBlock = 1024;
+
+// the check pass is built for AVX2 as well, picked once at load time
+#if defined(__x86_64__) && defined(__GNUC__)
+#define RULES_CLONES __attribute__((target_clones("avx2", "default")))
+#else
+#define RULES_CLONES
+#endif
+
+std::atomic<bool> running{true};
+
+void stop(int) { running = false; }
+
+// Advance the state of a rule, returns 1 if its event fires now, -1 if
+// a fired rule stopped holding and 0 otherwise
+int step(std::uint8_t& flags, uint32_t& since, bool held, uint32_t now, uint32_t duration)
+{
+    if (!held)
+    {
+        const bool fired = (flags & kFired) != 0;
+        flags = 0;
+        return fired ? -1 : 0;
+    }
+    if ((flags & kFired) != 0)
+    {
+        return 0;
+    }
+    if ((flags & kHolding) == 0)
+    {
+        flags = kHolding;
+        since = now;
+    }
+    if (now - since >= duration)
+    {
+        flags |= kFired;
+        return 1;
+    }
+    return 0;
+}
+
+// Return non zero if the state of any row in [begin, end) changes
+template <typename Compare, bool kAnyUser>
+RULES_CLONES uint32_t changes(const float* values, const StringPool::Handle* users,
+                              const std::uint8_t* flags, size_t begin, size_t end,
+                              float threshold, StringPool::Handle user)
+{
+    const Compare compare;
+    uint32_t changed = 0;
+    for (size_t row = begin; row < end; ++row)
+    {
+        // a holding row changes until it fired, any other until it is 0
+        const uint32_t held = 0u - static_cast<uint32_t>(
+            compare(values[row], threshold) & (kAnyUser || users[row] == user));
+        const uint32_t state = flags[row];
+        changed |= (held & ~state & kFired) | (~held & state);
+    }
+    return changed;
+}
+
+// Update the state of one rule for the rows [begin, end)
+template <typename Compare, bool kAnyUser>
+void evaluateBlock(const Rules::Rule& rule, size_t index, const float* values,
+                   const StringPool::Handle* users, ProcessTable::RuleState state,
+                   size_t begin, size_t end, const vector<Process>& processes,
+                   uint32_t now, vector<Rules::Event>& events)
+{
+    if (changes<Compare, kAnyUser>(values, users, state.flags, begin, end,
+                                   rule.threshold, rule.user) == 0)
+    {
+        return;
+    }
+    const Compare compare;
+    for (size_t row = begin; row < end; ++row)
+    {
+        const bool held = compare(values[row], rule.threshold) &
+                          (kAnyUser || users[row] == rule.user);
+        if (held ? (state.flags[row] & kFired) != 0 : state.flags[row] == 0)
+        {
+            continue;
+        }
+        const int transition = step(state.flags[row], state.since[row], held, now, rule.duration);
+        if (transition != 0)
+        {
+            const Process& process = processes[row];
+            events.push_back({transition > 0, index, process.Pid(), process.UserHandle(),
+                              process.CommandHandle(), values[row], false});
+        }
+    }
+}
+
+template <typename Compare>
+void evaluateBlock(const Rules::Rule& rule, size_t index, const float* values,
+                   const StringPool::Handle* users, ProcessTable::RuleState state,
+                   size_t begin, size_t end, const vector<Process>& processes,
+                   uint32_t now, vector<Rules::Event>& events)
+{
+    if (rule.anyUser)
+    {
+        evaluateBlock<Compare, true>(rule, index, values, users, state, begin, end, processes, now, events);
+    }
+    else
+    {
+        evaluateBlock<Compare, false>(rule, index, values, users, state, begin, end, processes, now, events);
+    }
+}
+
+bool compare(Rules::Compare op, float value, float threshold)
+{
+    switch (op)
+    {
+        case Rules::kGreater_:      return value > threshold;
+        case Rules::kGreaterEqual_: return value >= threshold;
+        case Rules::kLess_:         return value < threshold;
+        case Rules::kLessEqual_:    return value <= threshold;
+    }
+    return false;
+}
+
+string lower(string text)
+{
+    std::transform(text.begin(), text.end(), text.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+    return text;
+}
+
+bool percent(Rules::Metric metric)
+{
+    return metric == Rules::kCpu_ || metric == Rules::kSystemCpu_ ||
+           metric == Rules::kMemoryUsed_ || metric == Rules::kMemoryAvailable_;
+}
+
+// Value in the unit rules are written in
+string formatValue(Rules::Metric metric, float value)
+{
+    std::ostringstream text;
+    text << std::fixed << std::setprecision(1);
+    switch (metric)
+    {
+        case Rules::kRam_:
+        case Rules::kRss_:      text << value << "MB"; break;
+        case Rules::kWait_:     text << value << "ms/s"; break;
+        case Rules::kSwitches_:
+        case Rules::kFaults_:   return Format::Rate(value) + "/s";
+        case Rules::kLoad_:     text << std::setprecision(2) << value; break;
+        default:                text << value * 100 << "%"; break;
+    }
+    return text.str();
+}
+}  // namespace
+
+/**
+ * @brief Compile all rules of a config file, one rule per line
+ *
+ * @param[in]  path  Config file
+ * @param[out] error Receives file, line and reason of the first bad rule
+ * @return false if the file cannot be read or a rule is invalid
+ **/
+bool Rules::Load(const string& path, string& error)
+{
+    std::ifstream file(path);
+    if (!file)
+    {
+        error = path + ": " + std::strerror(errno);
+        return false;
+    }
+    string line;
+    for (int number = 1; std::getline(file, line); ++number)
+    {
+        line = line.substr(0, line.find('#'));
+        if (line.find_first_not_of(" \t\r") == string::npos)
+        {
+            continue;
+        }
+        if (!Add(line, error))
+        {
+            error = path + ":" + std::to_string(number) + ": " + error;
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Compile one rule like "process cpu > 90% for 30s",
+ *        "user alice rss > 8GB" or "memory available < 5%"
+ *
+ * @param[in]  text  Rule without comment
+ * @param[out] error Receives the reason if the rule is invalid
+ * @return false if the rule is invalid, nothing is added then
+ **/
+bool Rules::Add(const string& text, string& error)
+{
+    std::istringstream stream(text);
+    vector<string> tokens;
+    for (string token; stream >> token;)
+    {
+        tokens.push_back(token);
+    }
+    size_t next = 0;
+    const auto take = [&]() { return (next < tokens.size()) ? tokens[next++] : string(); };
+
+    Rule rule;
+    bool process = false;
+    string word = lower(take());
+    if (word == "process" || word == "user")
+    {
+        process = true;
+        if (word == "user")
+        {
+            const string user = take();
+            if (user.empty())
+            {
+                error = "user name missing";
+                return false;
+            }
+            rule.anyUser = false;
+            rule.user    = StringPool::Users().Intern(user);
+        }
+        word = lower(take());
+    }
+
+    if (process)
+    {
+        static const char* const names[] = {"cpu", "ram", "rss", "wait", "switches", "faults"};
+        const auto found = std::find(std::begin(names), std::end(names), word);
+        if (found == std::end(names))
+        {
+            error = "unknown process metric '" + word + "'";
+            return false;
+        }
+        rule.metric = static_cast<Metric>(found - std::begin(names));
+    }
+    else if (word == "cpu")
+    {
+        rule.metric = kSystemCpu_;
+    }
+    else if (word == "load")
+    {
+        rule.metric = kLoad_;
+    }
+    else if (word == "memory")
+    {
+        // "memory" alone is the used memory
+        const bool available = next < tokens.size() && lower(tokens[next]) == "available";
+        next += (next < tokens.size() && (available || lower(tokens[next]) == "used"));
+        rule.metric = available ? kMemoryAvailable_ : kMemoryUsed_;
+    }
+    else
+    {
+        error = "unknown metric '" + word + "'";
+        return false;
+    }
+
+    static const char* const compares[] = {">", ">=", "<", "<="};
+    word = take();
+    const auto found = std::find(std::begin(compares), std::end(compares), word);
+    if (found == std::end(compares))
+    {
+        error = "expected one of > >= < <= instead of '" + word + "'";
+        return false;
+    }
+    rule.compare = static_cast<Compare>(found - std::begin(compares));
+
+    // the unit may follow the number directly or as its own token
+    word = take();
+    char* end = nullptr;
+    const float value = std::strtof(word.c_str(), &end);
+    if (word.empty() || end == word.c_str())
+    {
+        error = "number expected instead of '" + word + "'";
+        return false;
+    }
+    string unit = lower(end);
+    if (unit.empty() && next < tokens.size() && lower(tokens[next]) != "for")
+    {
+        unit = lower(take());
+    }
+    if (percent(rule.metric) && (unit.empty() || unit == "%"))
+    {
+        rule.threshold = value / 100;
+    }
+    else if ((rule.metric == kRam_ || rule.metric == kRss_) && !unit.empty() &&
+             string("kmgt").find(unit[0]) != string::npos &&
+             (unit.size() == 1 || unit.substr(1) == "b" || unit.substr(1) == "ib"))
+    {
+        const float toMB[] = {1.0f / 1024, 1, 1024, 1024 * 1024};
+        rule.threshold = value * toMB[string("kmgt").find(unit[0])];
+    }
+    else if ((rule.metric == kRam_ || rule.metric == kRss_) && unit.empty())
+    {
+        rule.threshold = value;
+    }
+    else if (rule.metric == kWait_ && (unit.empty() || unit == "ms" || unit == "ms/s"))
+    {
+        rule.threshold = value;
+    }
+    else if ((rule.metric == kSwitches_ || rule.metric == kFaults_ || rule.metric == kLoad_) &&
+             (unit.empty() || (unit == "/s" && rule.metric != kLoad_)))
+    {
+        rule.threshold = value;
+    }
+    else
+    {
+        error = "unit '" + unit + "' does not fit the metric";
+        return false;
+    }
+
+    if (next < tokens.size())
+    {
+        word = lower(take());
+        const string duration = take();
+        const long amount = std::strtol(duration.c_str(), &end, 10);
+        const string suffix = lower(end);
+        const long scale = (suffix.empty() || suffix == "s") ? 1 : (suffix == "m") ? 60
+                         : (suffix == "h") ? 3600 : 0;
+        if (word != "for" || end == duration.c_str() || amount < 0 || scale == 0)
+        {
+            error = "expected a duration like 'for 30s', 'for 5m' or 'for 1h'";
+            return false;
+        }
+        rule.duration = static_cast<uint32_t>(amount * scale);
+    }
+    if (next < tokens.size())
+    {
+        error = "unexpected '" + tokens[next] + "'";
+        return false;
+    }
+
+    rule.text = tokens[0];
+    for (size_t i = 1; i < tokens.size(); ++i)
+    {
+        rule.text += " " + tokens[i];
+    }
+    if (process)
+    {
+        rule.state = _processRules++;
+        const auto position = std::upper_bound(_order.begin(), _order.end(), rule.metric,
+            [&](Metric metric, size_t index) { return metric < _program[index].metric; });
+        _order.insert(position, _program.size());
+    }
+    else
+    {
+        rule.state = _systemFlags.size();
+        _systemFlags.push_back(0);
+        _systemSince.push_back(0);
+    }
+    _program.push_back(std::move(rule));
+    return true;
+}
+
+/**
+ * @brief Return the compiled rules in the order they were added
+ **/
+const vector<Rules::Rule>& Rules::Program() const { return _program; }
+
+/**
+ * @brief Evaluate all rules on the latest Update of a system
+ *
+ * @param[in] system Sampled system
+ * @param[in] now    Monotonic time in seconds
+ **/
+void Rules::Evaluate(System& system, uint32_t now)
+{
+    _system[kSystemCpu_]       = system.CpuUtilization();
+    _system[kMemoryUsed_]      = system.MemoryUtilization();
+    _system[kMemoryAvailable_] = system.MemoryAvailable();
+    _system[kLoad_]            = system.LoadAverage();
+    Evaluate(system.Table(), now);
+}
+
+/**
+ * @brief Evaluate all rules on the processes of a table, system rules
+ *        use the values of the last Evaluate of a System. The events
+ *        raised are available from Events() until the next call.
+ *
+ * @param[in] table Processes and per row state of the rules
+ * @param[in] now   Monotonic time in seconds
+ **/
+void Rules::Evaluate(ProcessTable& table, uint32_t now)
+{
+    _events.clear();
+    const vector<Process>& processes = table.Processes();
+    table.ResizeRuleState(_processRules);
+
+    // fired rules of processes which exited since the last Evaluate
+    for (const auto& removed : table.RemovedRules())
+    {
+        if ((removed.flags & kFired) == 0)
+        {
+            continue;
+        }
+        for (size_t index = 0; index < _program.size(); ++index)
+        {
+            if (_program[index].metric < kSystemCpu_ && _program[index].state == removed.rule)
+            {
+                _events.push_back({false, index, removed.pid, removed.user, removed.command, 0, true});
+            }
+        }
+    }
+
+    for (size_t index = 0; index < _program.size(); ++index)
+    {
+        const Rule& rule = _program[index];
+        if (rule.metric < kSystemCpu_)
+        {
+            continue;
+        }
+        const float value = _system[rule.metric];
+        const int transition = step(_systemFlags[rule.state], _systemSince[rule.state],
+                                    compare(rule.compare, value, rule.threshold),
+                                    now, rule.duration);
+        if (transition != 0)
+        {
+            _events.push_back({transition > 0, index, -1, 0, 0, value, false});
+        }
+    }
+
+    const StringPool::Handle* users = table.Users();
+    for (size_t first = 0; first < _order.size();)
+    {
+        // rules of one metric, they share the value column
+        const Metric metric = _program[_order[first]].metric;
+        size_t last = first;
+        while (last < _order.size() && _program[_order[last]].metric == metric)
+        {
+            ++last;
+        }
+        const float* values = table.Values(static_cast<ProcessTable::Column>(metric));
+        for (size_t begin = 0; begin < processes.size(); begin += kBlock)
+        {
+            const size_t end = std::min(begin + kBlock, processes.size());
+            for (size_t i = first; i < last; ++i)
+            {
+                const size_t index = _order[i];
+                const Rule& rule   = _program[index];
+                const ProcessTable::RuleState state = table.Rule(rule.state);
+                switch (rule.compare)
+                {
+                    case kGreater_:
+                        evaluateBlock<std::greater<float>>(rule, index, values, users, state,
+                                                           begin, end, processes, now, _events);
+                        break;
+                    case kGreaterEqual_:
+                        evaluateBlock<std::greater_equal<float>>(rule, index, values, users, state,
+                                                                 begin, end, processes, now, _events);
+                        break;
+                    case kLess_:
+                        evaluateBlock<std::less<float>>(rule, index, values, users, state,
+                                                        begin, end, processes, now, _events);
+                        break;
+                    case kLessEqual_:
+                        evaluateBlock<std::less_equal<float>>(rule, index, values, users, state,
+                                                              begin, end, processes, now, _events);
+                        break;
+                }
+            }
+        }
+        first = last;
+    }
+}
+
+/**
+ * @brief Return the events raised by the last Evaluate
+ **/
+const vector<Rules::Event>& Rules::Events() const { return _events; }
+
+/**
+ * @brief Return if any process rule uses a rate metric (wait, switches
+ *        or faults), which are only sampled for watched processes
+ **/
+bool Rules::Rates() const
+{
+    return std::any_of(_program.begin(), _program.end(), [](const Rule& rule)
+    {
+        return rule.metric == kWait_ || rule.metric == kSwitches_ || rule.metric == kFaults_;
+    });
+}
+
+/**
+ * @brief Collect the processes rate rules apply to, to be passed to
+ *        System::Watch so their rates are sampled every tick
+ *
+ * @param[in]  table Processes of the latest Update
+ * @param[out] pids  All processes if a rate rule applies to every
+ *                   process, else the processes of the users of rate rules
+ **/
+void Rules::Watch(ProcessTable& table, vector<int>& pids) const
+{
+    pids.clear();
+    bool anyUser = false;
+    vector<StringPool::Handle> users;
+    for (const auto& rule : _program)
+    {
+        if (rule.metric == kWait_ || rule.metric == kSwitches_ || rule.metric == kFaults_)
+        {
+            anyUser = anyUser || rule.anyUser;
+            users.push_back(rule.user);
+        }
+    }
+    if (users.empty())
+    {
+        return;
+    }
+    const vector<Process>& processes = table.Processes();
+    const StringPool::Handle* rowUsers = table.Users();
+    for (size_t row = 0; row < processes.size(); ++row)
+    {
+        if (anyUser || std::find(users.begin(), users.end(), rowUsers[row]) != users.end())
+        {
+            pids.push_back(processes[row].Pid());
+        }
+    }
+}
+
+/**
+ * @brief Write one line per event of the last Evaluate, like
+ *        "2024-05-01T12:00:00 FIRING process cpu > 90% for 30s: pid 42
+ *        user alice value 97.0% command /usr/bin/app"
+ *
+ * @param[in] out Alert stream
+ **/
+void Rules::Report(std::ostream& out) const
+{
+    if (_events.empty())
+    {
+        return;
+    }
+    char timestamp[32];
+    const std::time_t now = std::time(nullptr);
+    std::strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+    for (const auto& event : _events)
+    {
+        const Rule& rule = _program[event.rule];
+        out << timestamp << (event.firing ? " FIRING " : " RESOLVED ") << rule.text << ":";
+        if (event.pid >= 0)
+        {
+            out << " pid " << event.pid << " user " << StringPool::Users().Get(event.user);
+        }
+        if (event.exited)
+        {
+            out << " exited";
+        }
+        else
+        {
+            out << " value " << formatValue(rule.metric, event.value);
+        }
+        if (event.pid >= 0)
+        {
+            // one line per event, even for command lines with newlines
+            string command(StringPool::Commands().Get(event.command));
+            std::replace_if(command.begin(), command.end(),
+                            [](unsigned char c) { return std::iscntrl(c); }, ' ');
+            out << " command " << command;
+        }
+        out << "\n";
+    }
+    out.flush();
+}
+
+/**
+ * @brief Headless alerting: update the system once per second and report
+ *        the events of all rules until SIGINT or SIGTERM
+ *
+ * @param[in] system Collecting or attached system
+ * @param[in] rules  Compiled rules
+ * @param[in] alerts File to append events to, empty for stdout
+ * @return process exit code
+ **/
+int Rules::Serve(System& system, Rules& rules, const string& alerts)
+{
+    std::ofstream file;
+    if (!alerts.empty())
+    {
+        file.open(alerts, std::ios::app);
+        if (!file)
+        {
+            std::cerr << "monitor: cannot write " << alerts << ": "
+                      << std::strerror(errno) << "\n";
+            return 1;
+        }
+    }
+    std::ostream& out = alerts.empty() ? std::cout : file;
+    std::signal(SIGINT, stop);
+    std::signal(SIGTERM, stop);
+
+    const auto start = std::chrono::steady_clock::now();
+    auto next = start;
+    vector<int> watched;
+    while (running)
+    {
+        system.Update();
+        const auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::steady_clock::now() - start).count();
+        rules.Evaluate(system, static_cast<uint32_t>(elapsed));
+        rules.Report(out);
+        // rates of the processes of rate rules are sampled from now on
+        rules.Watch(system.Table(), watched);
+        system.Watch(watched);
+        next += std::chrono::seconds(1);
+        // short sleeps, so a signal is handled quickly
+        while (running && std::chrono::steady_clock::now() < next)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,619 @@
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "process.h"
+#include "snapshot.h"
+#include "string_pool.h"
+#include "system.h"
+
+using std::size_t;
+using std::string;
+using std::uint32_t;
+using std::uint64_t;
+using std::vector;
+
+namespace Snapshot {
+struct Buffer {
+  std::atomic<uint64_t> sequence;  // odd while written
+  SystemRecord system;
+  uint32_t count;
+  uint32_t stringBytes;       // used part of strings
+  uint64_t stringGeneration;  // changes when strings are rebuilt
+  ProcessRecord processes[kMaxProcesses];
+  char strings[kStringBytes];
+};
+
+struct Layout {
+  std::atomic<uint32_t> magic;  // set once os and kernel are written
+  char os[kNameLength];
+  char kernel[kNameLength];
+  std::atomic<uint64_t> published;  // latest is buffers[published % 2]
+  Buffer buffers[2];
+};
+
+static_assert(std::atomic<uint64_t>::is_always_lock_free,
+              "shared memory needs lock free atomics");
+}  // namespace Snapshot
+
+namespace {
+std::atomic<bool> running{true};
+
+void stop(int) { running = false; }
+
+void copyName(char (&target)[Snapshot::kNameLength], const string& source)
+{
+    const size_t length = std::min(source.size(), Snapshot::kNameLength - 1);
+    std::memcpy(target, source.data(), length);
+    target[length] = '\0';
+}
+
+// Return the inode of an open segment, 0 on error
+ino_t inodeOf(int fd)
+{
+    struct stat status;
+    return (fstat(fd, &status) == 0) ? status.st_ino : 0;
+}
+
+// Return the inode of the segment a name currently refers to, 0 if none
+ino_t inodeOf(const string& name)
+{
+    const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+    {
+        return 0;
+    }
+    const ino_t inode = inodeOf(fd);
+    close(fd);
+    return inode;
+}
+}  // namespace
+
+/**
+ * @brief Collect once per second and publish every tick until SIGINT
+ *        or SIGTERM, the segment is removed on exit
+ *
+ * @param[in] system Collecting system
+ * @param[in] name   Name of the shared memory object, e.g. "/monitor"
+ * @return process exit code
+ **/
+int Snapshot::Serve(System& system, const string& name)
+{
+    SnapshotPublisher publisher;
+    if (!publisher.Open(name, system))
+    {
+        std::cerr << "monitor: cannot publish " << name << ": "
+                  << ((errno == EBUSY) ? "another publisher is running" : std::strerror(errno))
+                  << "\n";
+        return 1;
+    }
+    std::signal(SIGINT, stop);
+    std::signal(SIGTERM, stop);
+
+    auto next = std::chrono::steady_clock::now();
+    while (running)
+    {
+        system.Update();
+        publisher.Publish(system);
+        next += std::chrono::seconds(1);
+        // short sleeps, so a signal is handled quickly
+        while (running && std::chrono::steady_clock::now() < next)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Unmap and remove the segment, attached readers keep their mapping.
+ *        The lock is released only after the name is removed, so the
+ *        segment of a following publisher is never removed.
+ **/
+SnapshotPublisher::~SnapshotPublisher()
+{
+    forget(0);
+    forget(1);
+    if (_layout != nullptr)
+    {
+        munmap(_layout, sizeof(Snapshot::Layout));
+        shm_unlink(_name.c_str());
+    }
+    if (_fd >= 0)
+    {
+        close(_fd);
+    }
+}
+
+/**
+ * @brief Create the shared memory segment. The publisher holds a lock on
+ *        it for its lifetime: a segment whose lock can be taken was left
+ *        by a publisher which died and is replaced, a locked one fails.
+ *        The lock only counts once the name still refers to the locked
+ *        segment, another publisher may have replaced it meanwhile.
+ *
+ * @param[in] name   Name of the shared memory object, e.g. "/monitor"
+ * @param[in] system Provides operating system and kernel name
+ * @return false on error, errno is set, EBUSY if another publisher runs
+ **/
+bool SnapshotPublisher::Open(const string& name, System& system)
+{
+    int fd = -1;
+    for (int attempt = 0; fd < 0 && attempt < 8; ++attempt)
+    {
+        const int candidate = shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+        if (candidate < 0)
+        {
+            return false;
+        }
+        if (flock(candidate, LOCK_EX | LOCK_NB) != 0)
+        {
+            // running, or still setting up its segment
+            close(candidate);
+            errno = EBUSY;
+            return false;
+        }
+        struct stat status;
+        if (fstat(candidate, &status) != 0 || status.st_ino != inodeOf(name))
+        {
+            close(candidate);  // replaced or removed meanwhile
+            continue;
+        }
+        if (status.st_size != 0)
+        {
+            // left by a publisher which died, nobody else can hold it now
+            shm_unlink(name.c_str());
+            close(candidate);
+            continue;
+        }
+        fd = candidate;
+    }
+    if (fd < 0)
+    {
+        errno = EBUSY;
+        return false;
+    }
+    // pages are zero filled and only backed once written
+    if (ftruncate(fd, sizeof(Snapshot::Layout)) != 0)
+    {
+        const int error = errno;
+        shm_unlink(name.c_str());
+        close(fd);
+        errno = error;
+        return false;
+    }
+    void* address = mmap(nullptr, sizeof(Snapshot::Layout),
+                         PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (address == MAP_FAILED)
+    {
+        const int error = errno;
+        shm_unlink(name.c_str());
+        close(fd);
+        errno = error;
+        return false;
+    }
+
+    _fd     = fd;  // keeps the lock
+    _name   = name;
+    _layout = static_cast<Snapshot::Layout*>(address);
+    copyName(_layout->os, system.OperatingSystem());
+    copyName(_layout->kernel, system.Kernel());
+    for (auto& buffer : _layout->buffers)
+    {
+        buffer.strings[0]  = '\0';
+        buffer.stringBytes = 1;
+    }
+    _layout->magic.store(Snapshot::kMagic, std::memory_order_release);
+    return true;
+}
+
+/**
+ * @brief Write the latest sample of system into the buffer readers are
+ *        not using and make it the latest one. Beyond kMaxProcesses only
+ *        the top processes by cpu are published.
+ *
+ * @param[in] system Sampled system, Update must have been called
+ **/
+void SnapshotPublisher::Publish(System& system)
+{
+    if (_layout == nullptr)
+    {
+        return;
+    }
+    const uint64_t published = _layout->published.load(std::memory_order_relaxed);
+    const size_t index = (published + 1) % 2;
+    Snapshot::Buffer& buffer = _layout->buffers[index];
+
+    const uint64_t sequence = buffer.sequence.load(std::memory_order_relaxed);
+    buffer.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    Snapshot::SystemRecord& record = buffer.system;
+    record.cpu              = system.CpuUtilization();
+    record.memory           = system.MemoryUtilization();
+    record.memoryAvailable  = system.MemoryAvailable();
+    record.load             = system.LoadAverage();
+    record.upTime           = system.UpTime();
+    record.totalProcesses   = system.TotalProcesses();
+    record.runningProcesses = system.RunningProcesses();
+    record.waitRate         = system.WaitRate();
+    record.switchRate       = system.SwitchRate();
+    record.minorFaultRate   = system.MinorFaultRate();
+    record.majorFaultRate   = system.MajorFaultRate();
+    const vector<float>& cores = system.CoreUtilizations();
+    record.cores = static_cast<uint32_t>(std::min(cores.size(), Snapshot::kMaxCores));
+    std::copy_n(cores.begin(), record.cores, record.coreUtilizations);
+
+    const vector<Process>& processes = system.Processes();
+    const size_t count = std::min(processes.size(), Snapshot::kMaxProcesses);
+    if (processes.size() > Snapshot::kMaxProcesses)
+    {
+        system.Table().Top(count, _rows);
+    }
+    const auto process = [&](size_t i) -> const Process&
+    {
+        return (processes.size() > Snapshot::kMaxProcesses) ? processes[_rows[i]] : processes[i];
+    };
+
+    buffer.count = static_cast<uint32_t>(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        const Process& source = process(i);
+        Snapshot::ProcessRecord& p = buffer.processes[i];
+        p.pid       = source.Pid();
+        p.uid       = source.Uid();
+        p.startTime = source.StartTime();
+        p.cpu       = source.CpuUtilization();
+        p.recentCpu = source.RecentCpuUtilization();
+        p.ram       = source.Ram();
+        p.rss       = source.Rss();
+        p.upTime    = source.UpTime();
+        p.waitRate        = source.WaitRate();
+        p.voluntaryRate   = source.VoluntarySwitchRate();
+        p.involuntaryRate = source.InvoluntarySwitchRate();
+        p.minorFaultRate  = source.MinorFaultRate();
+        p.majorFaultRate  = source.MajorFaultRate();
+        p.rated           = source.Rated() ? 1 : 0;
+    }
+
+    // strings are appended to the area of this buffer; once it is full,
+    // it is rebuilt with the strings of the current processes only
+    for (int attempt = 0; attempt < 2; ++attempt)
+    {
+        bool full = false;
+        for (size_t i = 0; i < count; ++i)
+        {
+            const Process& source = process(i);
+            Snapshot::ProcessRecord& p = buffer.processes[i];
+            p.user    = store(buffer, source.UserHandle(), StringPool::Users(), _userOffsets[index], full);
+            p.command = store(buffer, source.CommandHandle(), StringPool::Commands(), _commandOffsets[index], full);
+        }
+        if (!full)
+        {
+            break;
+        }
+        buffer.stringBytes = 1;
+        ++buffer.stringGeneration;
+        forget(index);
+    }
+
+    buffer.sequence.store(sequence + 2, std::memory_order_release);
+    _layout->published.store(published + 1, std::memory_order_release);
+}
+
+/**
+ * @brief Copy an interned string into the string area of a buffer once
+ *        per generation of the area
+ *
+ * @param[out] full Set if the area has no room left for the string
+ * @return offset of the string, 0 (empty) if the area is full
+ **/
+uint32_t SnapshotPublisher::store(Snapshot::Buffer& buffer, StringPool::Handle handle,
+                                  StringPool& pool, vector<uint32_t>& offsets, bool& full)
+{
+    if (handle >= offsets.size())
+    {
+        offsets.resize(pool.Size(), 0);
+    }
+    if (offsets[handle] != 0)
+    {
+        return offsets[handle];
+    }
+    const std::string_view text = pool.Get(handle);
+    const uint32_t used = buffer.stringBytes;
+    if (text.empty())
+    {
+        return 0;
+    }
+    if (used + text.size() + 1 > Snapshot::kStringBytes)
+    {
+        full = true;
+        return 0;
+    }
+    std::memcpy(buffer.strings + used, text.data(), text.size());
+    buffer.strings[used + text.size()] = '\0';
+    buffer.stringBytes = used + text.size() + 1;
+    offsets[handle] = used;
+    // a cached command must not be evicted, its handle could be reused
+    if (&pool == &StringPool::Commands())
+    {
+        pool.Retain(handle);
+    }
+    return used;
+}
+
+/**
+ * @brief Drop the string offsets cached for a buffer and release the
+ *        commands stored in it
+ **/
+void SnapshotPublisher::forget(size_t index)
+{
+    vector<uint32_t>& commands = _commandOffsets[index];
+    for (StringPool::Handle handle = 0; handle < commands.size(); ++handle)
+    {
+        if (commands[handle] != 0)
+        {
+            StringPool::Commands().Release(handle);
+        }
+    }
+    std::fill(commands.begin(), commands.end(), 0);
+    std::fill(_userOffsets[index].begin(), _userOffsets[index].end(), 0);
+}
+
+/**
+ * @brief Unmap the segment
+ **/
+SnapshotReader::~SnapshotReader()
+{
+    forget(_mirrors[0]);
+    forget(_mirrors[1]);
+    if (_layout != nullptr)
+    {
+        munmap(const_cast<Snapshot::Layout*>(_layout), sizeof(Snapshot::Layout));
+    }
+}
+
+/**
+ * @brief Map the segment of a running publisher read-only
+ *
+ * @param[in] name Name of the shared memory object, e.g. "/monitor"
+ * @return false on error, errno is set
+ **/
+bool SnapshotReader::Open(const string& name)
+{
+    const int fd = shm_open(name.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+    {
+        return false;
+    }
+    const bool mapped = map(fd);
+    close(fd);
+    if (!mapped)
+    {
+        return false;
+    }
+    _name = name;
+    _records.reserve(Snapshot::kMaxProcesses);
+    return true;
+}
+
+/**
+ * @brief Map a segment in place of the current one, if it was set up
+ *        by its publisher
+ *
+ * @return false on error, errno is set, EPROTO if it is not set up
+ **/
+bool SnapshotReader::map(int fd)
+{
+    void* address = mmap(nullptr, sizeof(Snapshot::Layout), PROT_READ,
+                         MAP_SHARED, fd, 0);
+    if (address == MAP_FAILED)
+    {
+        return false;
+    }
+    const auto* layout = static_cast<const Snapshot::Layout*>(address);
+    if (layout->magic.load(std::memory_order_acquire) != Snapshot::kMagic)
+    {
+        munmap(address, sizeof(Snapshot::Layout));
+        errno = EPROTO;
+        return false;
+    }
+    if (_layout != nullptr)
+    {
+        munmap(const_cast<Snapshot::Layout*>(_layout), sizeof(Snapshot::Layout));
+    }
+    _layout    = layout;
+    _inode     = inodeOf(fd);
+    _published = 0;
+    for (auto& mirror : _mirrors)
+    {
+        forget(mirror);
+        mirror.generation = 0;
+    }
+    return true;
+}
+
+/**
+ * @brief Switch to the segment of a restarted publisher, the previous
+ *        one was unlinked but stays mapped until then
+ **/
+void SnapshotReader::reattach()
+{
+    const int fd = shm_open(_name.c_str(), O_RDONLY, 0);
+    if (fd < 0)
+    {
+        return;
+    }
+    if (inodeOf(fd) != _inode)
+    {
+        map(fd);
+    }
+    close(fd);
+}
+
+/**
+ * @brief Return the operating system name of the publisher
+ **/
+string SnapshotReader::OperatingSystem() const
+{
+    return (_layout != nullptr) ? string(_layout->os) : string();
+}
+
+/**
+ * @brief Return the kernel identifier of the publisher
+ **/
+string SnapshotReader::Kernel() const
+{
+    return (_layout != nullptr) ? string(_layout->kernel) : string();
+}
+
+/**
+ * @brief Copy the latest published tick. The copy is validated against
+ *        the buffer's sequence number and retried if the writer reused
+ *        the buffer meanwhile. Only the strings appended since the last
+ *        read of a buffer are copied.
+ *
+ * @param[out] system    System wide values
+ * @param[out] processes All published processes, strings interned into
+ *                       the local pools
+ * @return false if nothing was published yet or no consistent copy
+ *         could be taken
+ **/
+bool SnapshotReader::Read(Snapshot::SystemRecord& system, vector<Process>& processes)
+{
+    if (_layout == nullptr)
+    {
+        return false;
+    }
+    // no tick since the last Read, the publisher may have been restarted
+    if (_layout->published.load(std::memory_order_acquire) == _published)
+    {
+        reattach();
+    }
+    for (int attempt = 0; attempt < 16; ++attempt)
+    {
+        const uint64_t published = _layout->published.load(std::memory_order_acquire);
+        if (published == 0)
+        {
+            return false;
+        }
+        const Snapshot::Buffer& buffer = _layout->buffers[published % 2];
+        Mirror& mirror = _mirrors[published % 2];
+        const uint64_t before = buffer.sequence.load(std::memory_order_acquire);
+        if (before % 2 != 0)
+        {
+            continue;
+        }
+
+        system = buffer.system;
+        const size_t count = std::min<size_t>(buffer.count, Snapshot::kMaxProcesses);
+        _records.assign(buffer.processes, buffer.processes + count);
+        const uint64_t generation = buffer.stringGeneration;
+        const uint32_t stringBytes = std::min<uint32_t>(buffer.stringBytes, Snapshot::kStringBytes);
+        if (generation != mirror.generation)
+        {
+            // rebuilt by the writer, offsets refer to other strings now
+            mirror.generation = generation;
+            forget(mirror);
+        }
+        if (stringBytes > mirror.bytes)
+        {
+            mirror.text.resize(stringBytes);
+            std::memcpy(mirror.text.data() + mirror.bytes, buffer.strings + mirror.bytes,
+                        stringBytes - mirror.bytes);
+        }
+
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (buffer.sequence.load(std::memory_order_relaxed) != before)
+        {
+            continue;
+        }
+        mirror.bytes = std::max(mirror.bytes, stringBytes);
+        _published   = published;
+
+        system.cores = std::min<uint32_t>(system.cores, Snapshot::kMaxCores);
+        processes.clear();
+        for (const auto& record : _records)
+        {
+            Process::Record values;
+            values.pid       = record.pid;
+            values.uid       = record.uid;
+            values.startTime = record.startTime;
+            values.user      = intern(record.user, mirror, StringPool::Users(), mirror.users);
+            values.command   = intern(record.command, mirror, StringPool::Commands(), mirror.commands);
+            values.cpu       = record.cpu;
+            values.recentCpu = record.recentCpu;
+            values.ram       = record.ram;
+            values.rss       = record.rss;
+            values.upTime    = record.upTime;
+            values.waitRate        = record.waitRate;
+            values.voluntaryRate   = record.voluntaryRate;
+            values.involuntaryRate = record.involuntaryRate;
+            values.minorFaultRate  = record.minorFaultRate;
+            values.majorFaultRate  = record.majorFaultRate;
+            values.rated           = record.rated != 0;
+            processes.emplace_back(values);
+        }
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Map a string offset of a buffer to a handle of a local pool,
+ *        each distinct string is interned only once per generation
+ **/
+StringPool::Handle SnapshotReader::intern(uint32_t offset, const Mirror& mirror,
+                                          StringPool& pool,
+                                          std::unordered_map<uint32_t, StringPool::Handle>& handles)
+{
+    if (offset >= mirror.bytes)
+    {
+        offset = 0;
+    }
+    const auto found = handles.find(offset);
+    if (found != handles.end())
+    {
+        return found->second;
+    }
+    const char* text = mirror.text.data() + offset;
+    const auto handle = pool.Intern(std::string_view(text, strnlen(text, mirror.bytes - offset)));
+    handles.emplace(offset, handle);
+    // a cached command must not be evicted, its handle could be reused
+    if (&pool == &StringPool::Commands())
+    {
+        pool.Retain(handle);
+    }
+    return handle;
+}
+
+/**
+ * @brief Drop the strings copied from a buffer and release the commands
+ *        interned from them
+ **/
+void SnapshotReader::forget(Mirror& mirror)
+{
+    for (const auto& command : mirror.commands)
+    {
+        StringPool::Commands().Release(command.second);
+    }
+    mirror.commands.clear();
+    mirror.users.clear();
+    mirror.bytes = 1;
+}
@@ -0,0 +1,151 @@
+#include <cstddef>
+#include <cstring>
+#include <string_view>
+#include <utility>
+
+#include "string_pool.h"
+
+using std::size_t;
+using std::string_view;
+
+/**
+ * @brief Construct StringPool object
+ *
+ * @param[in] chunkSize Size of the arena chunks
+ **/
+StringPool::StringPool(size_t chunkSize)
+: _chunkSize(chunkSize)
+, _arena(chunkSize)
+{
+}
+
+/**
+ * @brief Return the handle of a string, the string is copied into the
+ *        arena on first sight only
+ *
+ * @param[in] text String to intern
+ **/
+StringPool::Handle StringPool::Intern(string_view text)
+{
+    const auto found = _handles.find(text);
+    if (found != _handles.end())
+    {
+        return found->second;
+    }
+
+    char* copy = static_cast<char*>(_arena.Allocate(text.size() + 1, 1));
+    std::memcpy(copy, text.data(), text.size());
+    copy[text.size()] = '\0';
+    _liveBytes += text.size() + 1;
+
+    Handle handle;
+    if (_free.empty())
+    {
+        handle = static_cast<Handle>(_strings.size());
+        _strings.emplace_back();
+        _references.push_back(0);
+    }
+    else
+    {
+        handle = _free.back();
+        _free.pop_back();
+    }
+    _strings[handle] = string_view(copy, text.size());
+    _handles.emplace(_strings[handle], handle);
+    return handle;
+}
+
+/**
+ * @brief Return the string of a handle, valid until the next Collect
+ **/
+string_view StringPool::Get(Handle handle) const { return _strings[handle]; }
+
+/**
+ * @brief Count a reference to a string, it is not evicted before the
+ *        reference is released again
+ **/
+void StringPool::Retain(Handle handle) { ++_references[handle]; }
+
+/**
+ * @brief Release a reference taken with Retain, the string is evicted by
+ *        the next Collect unless retained again meanwhile
+ **/
+void StringPool::Release(Handle handle)
+{
+    if (--_references[handle] == 0)
+    {
+        _released.push_back(handle);
+    }
+}
+
+/**
+ * @brief Evict released strings nobody retained again, their handles are
+ *        reused by Intern. The arena is rebuilt with the remaining strings
+ *        once evicted ones take more than half of it.
+ **/
+void StringPool::Collect()
+{
+    for (const Handle handle : _released)
+    {
+        // released twice before a Collect, or retained again
+        if (_references[handle] != 0 || _strings[handle].data() == nullptr)
+        {
+            continue;
+        }
+        _handles.erase(_strings[handle]);
+        _liveBytes -= _strings[handle].size() + 1;
+        _deadBytes += _strings[handle].size() + 1;
+        _strings[handle] = string_view();
+        _free.push_back(handle);
+    }
+    _released.clear();
+
+    if (_deadBytes < _chunkSize || _deadBytes < _liveBytes)
+    {
+        return;
+    }
+    Arena arena(_chunkSize);
+    _handles.clear();
+    for (Handle handle = 0; handle < _strings.size(); ++handle)
+    {
+        const string_view text = _strings[handle];
+        if (text.data() == nullptr)
+        {
+            continue;
+        }
+        char* copy = static_cast<char*>(arena.Allocate(text.size() + 1, 1));
+        std::memcpy(copy, text.data(), text.size() + 1);
+        _strings[handle] = string_view(copy, text.size());
+        _handles.emplace(_strings[handle], handle);
+    }
+    _arena     = std::move(arena);
+    _deadBytes = 0;
+}
+
+/**
+ * @brief Return number of handles, evicted ones waiting for reuse included
+ **/
+size_t StringPool::Size() const { return _strings.size(); }
+
+/**
+ * @brief Return number of bytes held by the arena
+ **/
+size_t StringPool::Bytes() const { return _arena.Capacity(); }
+
+/**
+ * @brief Return the pool shared by all processes for their command lines
+ **/
+StringPool& StringPool::Commands()
+{
+    static StringPool commands;
+    return commands;
+}
+
+/**
+ * @brief Return the pool shared by all processes for their user names
+ **/
+StringPool& StringPool::Users()
+{
+    static StringPool users(4 * 1024);
+    return users;
+}
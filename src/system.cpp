@@ -1,4 +1,6 @@
 #include <unistd.h>
+#include <algorithm>
+#include <chrono>
 #include <cstddef>
 #include <set>
 #include <string>
@@ -8,6 +10,7 @@
 #include "processor.h"
 #include "system.h"
 #include "linux_parser.h"
+#include "profiler.h"
 
 using std::set;
 using std::size_t;
@@ -15,19 +18,202 @@ using std::string;
 using std::vector;
 
 /**
- * @brief Construct System object
+ * @brief Construct System object, processes are read by the first Update
  **/
 System::System()
 : _os(LinuxParser::OperatingSystem())
 , _kernel(LinuxParser::Kernel()) 
 {
+}
+
+/**
+ * @brief Construct System object attached to a snapshot publisher,
+ *        nothing is read from /proc
+ *
+ * @param[in] source Opened reader, must outlive the System
+ **/
+System::System(SnapshotReader* source)
+: _os(source->OperatingSystem())
+, _kernel(source->Kernel())
+, _source(source)
+{
+}
+
+/**
+ * @brief Sample all metrics once and append them to the history,
+ *        expected to be called once per tick
+ *
+ * @param[in] provisional Cheap pass for a first frame: new processes are
+ *                        added from their stat only, see ProcessTable
+ **/
+void System::Update(bool provisional)
+{
+    if (_source != nullptr)
+    {
+        readSnapshot();
+    }
+    else
+    {
+        collect(provisional);
+    }
+    _history.RecordSystem(_cpuUtilization, _coreUtilizations,
+                          _memoryUtilization, _loadAverage);
+    _table.Top(MetricHistory::kTopProcesses, _topRows);
+    _history.RecordProcesses(_table.Processes(), _topRows);
+    if (_source == nullptr)
+    {
+        sampleProcesses();
+    }
+    if (_numaEnabled)
+    {
+        _numa.Update(_coreUtilizations);
+        _numa.UpdateProcesses(_table.Processes(), _topRows, _numaProcesses);
+    }
+}
 
+/**
+ * @brief Start sampling per node utilization and the page placement of
+ *        the top processes with every Update. Attached to a publisher no
+ *        nodes are reported, they live in /sys of the publisher's host.
+ *
+ * @param[in] processes Number of top processes to sample numa_maps for
+ **/
+void System::EnableNuma(std::size_t processes)
+{
+    if (_source != nullptr)
+    {
+        return;
+    }
+    _numa.Discover();
+    _numaEnabled   = true;
+    _numaProcesses = processes;
+}
+
+/**
+ * @brief Set the processes to sample scheduler and fault rates for in
+ *        the next ticks, besides the top processes
+ *
+ * @param[in] pids Process ids, e.g. of the visible rows
+ **/
+void System::Watch(const vector<int>& pids)
+{
+    _watched.assign(pids.begin(), pids.end());
+}
+
+/**
+ * @brief Sample all metrics from /proc
+ **/
+void System::collect(bool provisional)
+{
+    PROFILE_TICK();
+    // aggregate at index 0, cores behind it
+    LinuxParser::CpuUtilizations(_cpuJiffies, _cpuIds);
+    if (!_cpuJiffies.empty())
+    {
+        _cpuUtilization = _cpu.Utilization(_cpuJiffies[0]);
+    }
+
+    // cores are kept by cpu id, offline ones are missing in /proc/stat
+    // and report 0; a core gets a Processor on first sight, so its first
+    // delta is since boot
+    std::fill(_coreUtilizations.begin(), _coreUtilizations.end(), 0.0f);
+    for (size_t i = 1; i < _cpuJiffies.size(); ++i)
+    {
+        const int id = _cpuIds[i];
+        if (id < 0)
+        {
+            continue;
+        }
+        while (static_cast<size_t>(id) >= _cores.size())
+        {
+            _cores.emplace_back(vector<long>(_cpuJiffies[i].size(), 0));
+        }
+        if (static_cast<size_t>(id) >= _coreUtilizations.size())
+        {
+            _coreUtilizations.resize(id + 1, 0.0f);
+        }
+        _coreUtilizations[id] = _cores[id].Utilization(_cpuJiffies[i]);
+    }
+
+    // one read of /proc/meminfo for used and available memory
+    LinuxParser::MemInfo memory;
+    LinuxParser::Meminfo(memory);
+    const float total  = static_cast<float>(memory.total);
+    _memoryUtilization = (memory.total == 0) ? 0 : (memory.total - memory.free) / total;
+    _memoryAvailable   = (memory.total == 0) ? 0 : memory.available / total;
+    _loadAverage       = LinuxParser::LoadAverage();
+    _upTime            = LinuxParser::UpTime();
+    _totalProcesses    = LinuxParser::TotalProcesses();
+    _runningProcesses  = LinuxParser::RunningProcesses();
+    updateScheduling();
+    updateProcesses(provisional);
+}
+
+/**
+ * @brief Turn the system wide scheduling counters into rates per second
+ **/
+void System::updateScheduling()
+{
+    LinuxParser::SchedCounters sched;
+    LinuxParser::Scheduling(sched);
+    const auto now = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count());
+    if (_schedAt != 0 && now > _schedAt)
+    {
+        const float seconds = static_cast<float>(now - _schedAt) / 1e9f;
+        const auto rate = [&](long current, long previous)
+        {
+            return static_cast<float>(current - previous) / seconds;
+        };
+        _waitRate       = (sched.waitNs < 0) ? -1 : rate(sched.waitNs, _sched.waitNs) / 1e6f;
+        _switchRate     = rate(sched.contextSwitches, _sched.contextSwitches);
+        _majorFaultRate = rate(sched.majorFaults, _sched.majorFaults);
+        _minorFaultRate = rate(sched.faults, _sched.faults) - _majorFaultRate;
+    }
+    _sched   = sched;
+    _schedAt = now;
+}
+
+/**
+ * @brief Sample scheduler and fault rates of the top and watched
+ *        processes only, so the cost does not grow with all processes
+ **/
+void System::sampleProcesses()
+{
+    _samplePids.clear();
+    for (const auto row : _topRows)
+    {
+        _samplePids.push_back(_table.Processes()[row].Pid());
+    }
+    _samplePids.insert(_samplePids.end(), _watched.begin(), _watched.end());
+    _table.Sample(_samplePids);
+}
 
- const auto pIds = LinuxParser::Pids();
- for (const auto id : pIds)
- {
-    _processes.emplace_back(Process(id)); 
- } 
+/**
+ * @brief Take over the latest tick of the publisher, the previous
+ *        values are kept if none could be read
+ **/
+void System::readSnapshot()
+{
+    if (!_source->Read(_snapshot, _snapshotProcesses))
+    {
+        return;
+    }
+    _cpuUtilization    = _snapshot.cpu;
+    _memoryUtilization = _snapshot.memory;
+    _memoryAvailable   = _snapshot.memoryAvailable;
+    _loadAverage       = _snapshot.load;
+    _upTime            = _snapshot.upTime;
+    _totalProcesses    = _snapshot.totalProcesses;
+    _runningProcesses  = _snapshot.runningProcesses;
+    _waitRate          = _snapshot.waitRate;
+    _switchRate        = _snapshot.switchRate;
+    _minorFaultRate    = _snapshot.minorFaultRate;
+    _majorFaultRate    = _snapshot.majorFaultRate;
+    _coreUtilizations.assign(_snapshot.coreUtilizations,
+                             _snapshot.coreUtilizations + _snapshot.cores);
+    _table.Update(_snapshotProcesses);
 }
 
 /**
@@ -36,21 +222,73 @@ System::System()
 Processor& System::Cpu() { return _cpu; }
 
 /**
- * @brief Return a container composed of the system's processes
+ * @brief Return the aggregate CPU utilization sampled by the last Update
+ **/
+float System::CpuUtilization() const { return _cpuUtilization; }
+
+/**
+ * @brief Return the utilization per core sampled by the last Update,
+ *        indexed by cpu id, 0 for offline cpus
+ **/
+const vector<float>& System::CoreUtilizations() const { return _coreUtilizations; }
+
+/**
+ * @brief Return a container composed of the system's processes,
+ *        unordered, see ProcessTable::Select for sorted views
+ **/
+vector<Process>& System::Processes() { return _table.Processes(); }
+
+/**
+ * @brief Return the table of processes with its indices
+ **/
+ProcessTable& System::Table() { return _table; }
+
+/**
+ * @brief Return the load average sampled by the last Update
+ **/
+float System::LoadAverage() const { return _loadAverage; }
+
+/**
+ * @brief Return the time all tasks spent waiting on run queues in ms per
+ *        second, negative if the kernel has no /proc/schedstat
  **/
-vector<Process>& System::Processes() 
+float System::WaitRate() const { return _waitRate; }
+
+/**
+ * @brief Return the context switches per second
+ **/
+float System::SwitchRate() const { return _switchRate; }
+
+/**
+ * @brief Return the minor page faults per second
+ **/
+float System::MinorFaultRate() const { return _minorFaultRate; }
+
+/**
+ * @brief Return the major page faults per second
+ **/
+float System::MajorFaultRate() const { return _majorFaultRate; }
+
+/**
+ * @brief Return the NUMA nodes, utilization is sampled once enabled
+ **/
+const Numa& System::NumaNodes() const { return _numa; }
+
+/**
+ * @brief Return the history of all sampled metrics
+ **/
+const MetricHistory& System::History() const { return _history; }
+
+/**
+ * @brief Refresh the process table
+ **/
+void System::updateProcesses(bool provisional) 
 { 
-    const auto pIds = LinuxParser::Pids(); 
-    
-    // dismiss old data
-    _processes = {};
-    for (const auto id : pIds)
     {
-        _processes.emplace_back(Process(id)); 
-    } 
-    std::sort(_processes.begin(), _processes.end());
-    
-    return _processes; 
+        PROFILE_SCOPE(Profiler::kPids_);
+        LinuxParser::Pids(_pids); 
+    }
+    _table.Update(_pids, provisional);
 }
 
 /**
@@ -59,9 +297,15 @@ vector<Process>& System::Processes()
 std::string System::Kernel() const { return _kernel; }
 
 /**
- * @brief Return the system's memory utilization
+ * @brief Return the system's memory utilization sampled by the last Update
+ **/
+float System::MemoryUtilization() { return _memoryUtilization; }
+
+/**
+ * @brief Return the share of memory available for new allocations without
+ *        swapping, sampled by the last Update
  **/
-float System::MemoryUtilization() { return LinuxParser::MemoryUtilization(); }
+float System::MemoryAvailable() const { return _memoryAvailable; }
 
 /**
  * @brief Return the operating system name
@@ -69,16 +313,19 @@ float System::MemoryUtilization() { return LinuxParser::MemoryUtilization(); }
 std::string System::OperatingSystem() const { return _os; }
 
 /**
- * @brief Return the number of processes actively running on the system
+ * @brief Return the number of processes actively running on the system,
+ *        sampled by the last Update
  **/
-int System::RunningProcesses() { return LinuxParser::RunningProcesses(); }
+int System::RunningProcesses() { return _runningProcesses; }
 
 /**
- * @brief Return the total number of processes on the system
+ * @brief Return the total number of processes on the system,
+ *        sampled by the last Update
  **/
-int System::TotalProcesses() { return LinuxParser::TotalProcesses(); }
+int System::TotalProcesses() { return _totalProcesses; }
 
 /**
- * @brief Return the number of seconds since the system started running
+ * @brief Return the number of seconds since the system started running,
+ *        sampled by the last Update
  **/
-long int System::UpTime() { return LinuxParser::UpTime(); }
\ No newline at end of file
+long int System::UpTime() { return _upTime; }
\ No newline at end of file